@@ -0,0 +1,68 @@
+import flecs
+import time
+
+N = 20000
+FLIPS = 10
+
+def world_with(trait=None, tag="Stunned"):
+    ecs = flecs.World()
+    ecs.component("Position", {"x": "f32", "y": "f32"})
+    if trait:
+        ecs.entity(tag).add_trait(trait)
+    entities = []
+    for i in range(N):
+        e = ecs.entity()
+        e.set("Position", {"x": i, "y": i})
+        entities.append(e)
+    return ecs, entities
+
+def tables(ecs):
+    return ecs.memory_report(python=False)["tables"]["count"]
+
+def bench(name, flip, trait=None):
+    ecs, entities = world_with(trait)
+    start = time.perf_counter()
+    for f in range(FLIPS):
+        for e in entities:
+            flip(e, f % 2 == 0)
+    elapsed = time.perf_counter() - start
+    print(f"{name:<28} {elapsed / (FLIPS * N) * 1e9:8.0f} ns/flip  {tables(ecs)} tables")
+
+def main():
+    # Adding and removing a plain tag moves the entity (and all of its
+    # components) to another table on every flip
+    bench("add/remove tag", lambda e, on: e.add("Stunned") if on else e.remove("Stunned"))
+
+    # Non-fragmenting and sparse tags don't change the table of the entity
+    bench("add/remove DontFragment", lambda e, on: e.add("Stunned") if on else e.remove("Stunned"), "DontFragment")
+
+    # Toggling flips a bit in the table, the tag is added once
+    def toggle(e, on):
+        if not e.has("Stunned"):
+            e.add("Stunned")
+        if on:
+            e.enable("Stunned")
+        else:
+            e.disable("Stunned")
+    bench("enable/disable CanToggle", toggle, "CanToggle")
+
+    # Many-target relationships: one table per target unless the relation is a union
+    for trait in (None, "Union"):
+        ecs, entities = world_with()
+        if trait:
+            ecs.entity("Targets").add_trait(trait)
+        start = time.perf_counter()
+        for i, e in enumerate(entities):
+            e.add("Targets", f"Enemy{i % 500}")
+        elapsed = time.perf_counter() - start
+        print(f"{'(Targets, *) ' + (trait or 'plain'):<28} {elapsed / N * 1e9:8.0f} ns/add   {tables(ecs)} tables")
+
+    # Queries skip disabled toggles and match non-fragmenting ids as usual
+    ecs, entities = world_with("CanToggle")
+    for e in entities[:10]:
+        e.add("Stunned")
+    entities[0].disable("Stunned")
+    print(sum(1 for _ in ecs.query("Stunned")), "stunned")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,29 @@
+import flecs
+import numpy as np
+from multiprocessing import Process
+
+def worker():
+    # Maps the segment read-only, no pickling of world state
+    view = flecs.SharedView("flecs_training")
+    arrays = view.read()
+    print(f"version {view.version()}: {len(arrays['Position.entities'])} positions")
+    print(arrays["graph.edge_index"].shape, arrays["graph.edge_attr"].shape)
+
+def main():
+    ecs = flecs.World()
+    ecs.component("Position", {"x": "f32", "y": "f32"})
+
+    nodes = [ecs.entity(f"Node{i}").set("Position", {"x": i, "y": -i}) for i in range(1000)]
+    for a, b in zip(nodes, nodes[1:]):
+        a.add("Link", b, weight=0.5)
+
+    # Republished after every progress()
+    ecs.export_shared("flecs_training", components=["Position"], graph=True)
+    ecs.progress()
+
+    p = Process(target=worker)
+    p.start()
+    p.join()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,37 @@
+import flecs
+from dataclasses import dataclass
+
+@dataclass
+class Position:
+    x: float
+    y: float
+
+@dataclass
+class WorldPosition:
+    x: float
+    y: float
+
+def main():
+    ecs = flecs.World()
+
+    # Parents are processed before their children, parent is None for roots
+    @ecs.system(WorldPosition, Position, cascade=True)
+    def propagate(e, world_pos, pos, parent_world_pos):
+        px, py = (parent_world_pos.x, parent_world_pos.y) if parent_world_pos else (0, 0)
+        world_pos.x = px + pos.x
+        world_pos.y = py + pos.y
+
+    sun = ecs.entity("Sun", [Position(1, 1), WorldPosition(0, 0)])
+    earth = ecs.entity("Earth", [Position(3, 3), WorldPosition(0, 0)]).child_of(sun)
+    ecs.entity("Venus", [Position(2, 2), WorldPosition(0, 0)]).child_of(sun)
+    ecs.entity("Luna", [Position(0.1, 0.1), WorldPosition(0, 0)]).child_of(earth)
+
+    ecs.progress()
+
+    # Whole subtree in one call
+    tree = ecs.hierarchy(sun, order="depth")
+    for eid, parent, depth in zip(tree["ids"], tree["parent"], tree["depth"]):
+        print("  " * depth + f"{eid} (parent index {parent})")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,41 @@
+import flecs
+
+class Inventory:
+    def __init__(self, items):
+        self.items = items
+
+def main():
+    ecs = flecs.World()
+
+    ecs.component("Position", {"x": "f32", "y": "f32"})
+
+    # Every add, remove, set and delete is appended to the journal, with a
+    # marker after each frame. A background thread writes it to disk.
+    ecs.start_journal("world.journal")
+
+    player = ecs.entity("Player")
+    player.set(Inventory(["sword"]))
+    crate = ecs.entity("Crate")
+
+    for frame in range(10):
+        player.set("Position", {"x": frame, "y": 0})
+        if frame == 3:
+            player.set(Inventory(["sword", "key"]))
+        if frame == 7:
+            # In-place changes are only journaled through a tracked component
+            player.get(Inventory, track=True).items = ["sword", "key", "map"]
+        if frame == 5:
+            crate.destroy()
+        ecs.progress()
+
+    ecs.stop_journal()
+
+    # Rebuild the world as it was after its 4th frame, without running systems
+    replayed = flecs.World.replay("world.journal", until_frame=4)
+    player = replayed.lookup("Player")
+    print(player.get("Position"))
+    print(player.get(Inventory).items)
+    print(replayed.lookup("Crate").is_alive())
+
+if __name__ == "__main__":
+    main()
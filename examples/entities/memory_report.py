@@ -0,0 +1,29 @@
+import flecs
+from dataclasses import dataclass
+
+@dataclass
+class Inventory:
+    items: list
+
+def main():
+    ecs = flecs.World()
+    ecs.component("Position", {"x": "f32", "y": "f32"})
+
+    for i in range(10000):
+        e = ecs.entity(f"Npc{i}")
+        e.set("Position", {"x": i, "y": i})
+        e.set(Inventory(list(range(i % 50))))
+        e.add("Faction", f"Faction{i % 20}")
+
+    report = ecs.memory_report()
+    print(f"total: {report['total_bytes']} bytes in {report['tables']['count']} tables"
+          f" ({report['estimated_bytes']} estimated)")
+    for archetype in report["archetypes"][:3]:
+        print(archetype["bytes"], archetype["type"])
+    print(report["python"])
+
+    # Skip Python objects when sampling every frame
+    print(ecs.memory_report(python=False)["total_bytes"])
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,55 @@
+import multiprocessing as mp
+import flecs
+
+def mirror(conn):
+    # Keeps a copy of the simulation world, e.g. for a visualizer
+    ecs = flecs.World()
+    while True:
+        delta = conn.recv_bytes()
+        if not delta:
+            break
+        version = ecs.apply_delta(delta)
+        q = ecs.query("Position")
+        print(f"mirror at version {version}: {q.count()} entities,",
+              "mean x", q.aggregate("Position", "x", "mean"))
+
+def main():
+    ecs = flecs.World()
+    ecs.component("Position", {"x": "f32", "y": "f32"})
+    ecs.component("Velocity", {"x": "f32", "y": "f32"})
+
+    # Changes are tracked per table, so moving entities get their own table
+    moving = []
+    for i in range(1000):
+        e = ecs.entity()
+        e.set("Position", {"x": 0, "y": 0})
+        if i % 10 == 0:
+            e.set("Velocity", {"x": 1, "y": 0})
+            moving.append(e)
+
+    parent, child = mp.Pipe()
+    process = mp.Process(target=mirror, args=(child,))
+    process.start()
+
+    # The first delta holds the whole world
+    delta, version = ecs.diff()
+    parent.send_bytes(delta)
+    print("full state:", len(delta), "bytes")
+
+    for frame in range(5):
+        for e in moving:
+            p = e.get("Position")
+            v = e.get("Velocity")
+            e.set("Position", {"x": p["x"] + v["x"], "y": p["y"] + v["y"]})
+        moving.pop().destroy()
+
+        # Created and deleted entities, added and removed ids, changed native columns
+        delta, version = ecs.diff(version)
+        parent.send_bytes(delta)
+        print(f"frame {frame}:", len(delta), "bytes")
+
+    parent.send_bytes(b"")
+    process.join()
+
+if __name__ == "__main__":
+    main()
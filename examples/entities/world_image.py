@@ -0,0 +1,28 @@
+import flecs
+import numpy as np
+
+class Mesh:
+    def __init__(self, vertices):
+        self.vertices = vertices
+
+def main():
+    ecs = flecs.World()
+
+    ecs.component("Position", {"x": "f32", "y": "f32"})
+
+    for i in range(100):
+        e = ecs.entity(f"Node{i}")
+        e.set("Position", {"x": i, "y": i * 2})
+        e.set(Mesh(np.zeros((1024, 3), dtype=np.float32)))
+
+    # Native columns are written as raw blocks, numpy buffers out of band
+    ecs.save_image("world.img")
+
+    # The image is memory mapped, mesh vertices reference the mapping
+    loaded = flecs.World.load_image("world.img")
+    node = loaded.lookup("Node42")
+    print(node.get("Position"))
+    print(node.get(Mesh).vertices.shape)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,24 @@
+import flecs
+import numpy as np
+from dataclasses import dataclass
+
+@dataclass
+class Health:
+    value: float
+
+def main():
+    ecs = flecs.World()
+
+    Damaged = ecs.event("Damaged")
+
+    # Called once per emit with all matching entity ids
+    @ecs.observer(Health, events=[Damaged], batch=True)
+    def on_damaged(ids, amount):
+        print(f"{len(ids)} entities took {amount} damage")
+
+    ids = np.array([ecs.entity(f"Unit{i}").set(Health(100)).id() for i in range(10000)], dtype=np.int64)
+
+    ecs.emit(Damaged, ids[::2], payload=5.0, component=Health)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,36 @@
+import flecs
+
+def main():
+    ecs = flecs.World()
+
+    ecs.component("Health", {"hp": "f32"})
+
+    towns = [ecs.entity(f"Town{i}") for i in range(3)]
+    factions = [ecs.entity(f"Faction{i}") for i in range(2)]
+    for i in range(600):
+        e = ecs.entity()
+        e.add("Location", towns[i % 3])
+        e.add("MemberOf", factions[i % 2])
+        e.set("Health", {"hp": i % 100})
+
+    # Counted in C++, no rows are created
+    q = ecs.query("Health", ("Location", "$town"))
+    print(q.count(), "entities with a location")
+
+    # Per value of a query variable, or per target of any relationship
+    names = {town.id(): town.name() for town in towns}
+    town_ids, counts = q.group_count("$town")
+    for town, count in zip(town_ids, counts):
+        print(names[town], count)
+
+    ids, hp = q.aggregate("Health", "hp", "sum", by="MemberOf")
+    print(dict(zip(ids.tolist(), hp.tolist())))
+
+    print("mean hp", q.aggregate("Health", "hp", "mean"))
+
+    # where filters apply before aggregating
+    wounded = ecs.query("Health", where=[("Health", "hp", "<", 10)])
+    print(wounded.count(), "wounded, max hp", wounded.aggregate("Health", "hp", "max"))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,25 @@
+import flecs
+
+def main():
+    ecs = flecs.World()
+
+    ecs.component("Health", {"hp": "f32"})
+
+    cells = [ecs.entity(f"Cell{i}") for i in range(3)]
+    for i in range(12):
+        e = ecs.entity(f"Agent{i}", ["Agent"])
+        e.add("InCell", cells[i % 3])
+        e.set("Health", {"hp": 100 - i * 7})
+
+    # Tables are bucketed by the target of InCell
+    query = ecs.query("Agent", group_by=("InCell", "*"))
+    for (e,) in query.iter(group=cells[1]):
+        print(f"{e.name()} is in {cells[1].name()}")
+
+    # Results are sorted on a native component field
+    query = ecs.query("Agent", "Health", order_by=("Health", "hp"))
+    for (e,) in query.iter():
+        print(f"{e.name()} hp={e.get('Health')['hp']}")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,45 @@
+import ctypes
+import flecs
+import numpy as np
+import random
+
+# double kernel(int32_t count, const uint64_t* entities, void* const* columns, uint8_t* mask)
+KERNEL = ctypes.CFUNCTYPE(ctypes.c_double, ctypes.c_int32, ctypes.POINTER(ctypes.c_uint64),
+    ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_uint8))
+
+def main():
+    ecs = flecs.World()
+    ecs.component("Health", {"value": "f32"})
+
+    # Tables of very different sizes
+    random.seed(0)
+    for i in range(20000):
+        e = ecs.entity()
+        e.set("Health", {"value": random.random() * 100})
+        if i % 1000 == 0:
+            e.add("Boss")
+        elif i % 3 == 0:
+            e.add("Elite")
+
+    q = ecs.query("Health")
+
+    # Python kernels get the entity ids and a numpy view of each native column
+    # per chunk. Numbers are added up and arrays concatenated in chunk order.
+    total = q.parallel_for(lambda ids, health: float(health["value"].sum()), threads=4)
+    low = q.parallel_for(lambda ids, health: ids[health["value"] < 10], threads=4)
+    print(f"total health {total:.1f}, {len(low)} low")
+
+    # Native kernels run without the GIL. A compiled kernel would be loaded with
+    # ctypes.CDLL; this one is a ctypes callback to show the signature.
+    @KERNEL
+    def count_low(count, entities, columns, mask):
+        health = np.ctypeslib.as_array(ctypes.cast(columns[0], ctypes.POINTER(ctypes.c_float)), (count,))
+        selected = health < 10
+        np.ctypeslib.as_array(mask, (count,))[:] = selected
+        return float(selected.sum())
+
+    count, ids = q.parallel_for(count_low, threads=4, chunk_size=1024, select=True)
+    print(int(count), ids[:5])
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,31 @@
+import flecs
+import numpy as np
+
+def main():
+    ecs = flecs.World()
+
+    ecs.component("Position", {"x": "f32", "y": "f32"})
+
+    rng = np.random.default_rng(0)
+    agents = []
+    for i in range(1000):
+        e = ecs.entity(f"Agent{i}")
+        x, y = rng.uniform(0, 100, 2)
+        e.set("Position", {"x": x, "y": y})
+        agents.append(e)
+
+    # Kept up to date by an observer on OnSet/OnRemove
+    ecs.spatial_index("Position", cell_size=5.0)
+
+    near = ecs.within_radius((50, 50), 5.0)
+    print(f"{len(near)} agents within 5 of the center")
+
+    agents[0].set("Position", {"x": 50.0, "y": 50.0})
+    print(agents[0].id() in ecs.within_radius((50, 50), 0.5))
+
+    # Batched nearest neighbor lookup
+    ids, dist = ecs.knn(np.array([[0, 0], [100, 100]], dtype=np.float32), k=3)
+    print(ids, dist)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,27 @@
+import flecs
+import random
+
+def main():
+    ecs = flecs.World()
+
+    random.seed(0)
+    for i in range(100000):
+        e = ecs.entity()
+        for tag in ("Infected", "Vaccinated", "Hospitalized"):
+            if random.random() < 0.3:
+                e.add(tag)
+
+    infected = ecs.tag_set("Infected")
+    vaccinated = ecs.tag_set("Vaccinated")
+    hospitalized = ecs.tag_set("Hospitalized")
+
+    # Infected and hospitalized but not vaccinated
+    population = (infected & hospitalized) - vaccinated
+    print(f"{population.count()} of {len(infected)} infected")
+
+    # Live sets follow tag changes, results of operators are snapshots
+    ecs.entity("Patient0").add("Infected")
+    print(len(infected), population.to_numpy()[:5])
+
+if __name__ == "__main__":
+    main()
@@ -32,5 +32,10 @@ def main():
         ):
         print(f"{person} eats {food} which grow in {place}")
 
+    # Memoized queries are only re-evaluated after matching ids are added or removed
+    healthy_eaters = ecs.query(("Eats", "$food"), ("$food", "Healthy"), memoize=True)
+    for frame in range(3):
+        print(f"frame {frame}: {sum(1 for _ in healthy_eaters)} healthy meals")
+
 if __name__ == "__main__":
     main()
\ No newline at end of file
@@ -0,0 +1,28 @@
+import flecs
+
+def main():
+    ecs = flecs.World()
+
+    units = [ecs.entity(f"Unit{i}", ["Unit"]) for i in range(10)]
+    for unit in units[:4]:
+        unit.add("Selected")
+
+    # Kept up to date by observers, no query runs when it is read
+    selected = ecs.view("Unit", "Selected")
+    print(len(selected), selected.ids())
+
+    seen = selected.version()
+    units[0].remove("Selected")
+    units[7].add("Selected")
+    units[8].add("Selected")
+    units[8].remove("Selected")
+
+    # Only what changed since the last read; Unit8 came and went and isn't reported
+    added, removed = selected.delta(seen)
+    print("added", added, "removed", removed)
+
+    # ids() is a copy, fetch it again after the version changes
+    print(units[7].id() in selected, selected.ids())
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,35 @@
+import flecs
+
+def main():
+    ecs = flecs.World()
+
+    ecs.component("Health", {"hp": "f32"})
+    ecs.component("Team", {"id": "i32"})
+
+    for i in range(1000):
+        e = ecs.entity(f"Unit{i}", ["Unit"])
+        e.set("Health", {"hp": i % 100})
+        e.set("Team", {"id": i % 4})
+        if i % 10 == 0:
+            e.add("Leader")
+
+    # Filters run over the component columns in C++, only matching rows reach Python
+    low = ecs.query("Unit", "Health", where=[("Health", "hp", "<", 5)])
+    print(sum(1 for _ in low.iter()), "units with hp < 5")
+
+    ranged = ecs.query("Unit", "Health", "Team", where=[
+        ("Health", "hp", "between", (40, 45)),
+        ("Team", "id", "in", [1, 3])])
+    for (e,) in ranged.iter():
+        print(e.name(), e.get("Health")["hp"], e.get("Team")["id"])
+        break
+
+    # Id sets work for "in" on entity fields, e.g. a TagSet or View
+    leaders = ecs.tag_set("Leader")
+    ecs.component("Follows", {"leader": "entity"})
+    ecs.lookup("Unit1").set("Follows", {"leader": ecs.lookup("Unit0").id()})
+    followers = ecs.query("Follows", where=[("Follows", "leader", "in", leaders)])
+    print([e.name() for (e,) in followers.iter()])
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,31 @@
+import flecs
+from dataclasses import dataclass
+
+@dataclass
+class Since:
+    year: int
+
+def main():
+    ecs = flecs.World()
+
+    alice = ecs.entity("Alice")
+    bob = ecs.entity("Bob")
+    carol = ecs.entity("Carol")
+
+    # Native pair data, "Friend" becomes a component with a weight field
+    alice.add("Friend", bob, weight=0.8)
+    alice.add("Friend", carol, weight=0.3)
+    bob.add("Friend", carol, weight=0.5)
+
+    # Python objects are stored per pair
+    alice.add("Knows", Since(2019))
+
+    print(alice.get_relationship_component("Friend", "Bob"))
+    print(alice.get_relationship_component("Knows", "Since"))
+
+    graph = ecs.export_graph_numpy()
+    print(graph["edge_index"])
+    print(graph["edge_attr_names"], graph["edge_attr"])
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,40 @@
+import asyncio
+import flecs
+from dataclasses import dataclass
+
+@dataclass
+class Position:
+    x: float
+    y: float
+
+async def log_lines():
+    for i in range(3):
+        print("orchestration step", i)
+        await asyncio.sleep(0)
+
+async def main():
+    ecs = flecs.World()
+
+    # Python systems of an asynchronous frame run on the thread that awaits it
+    @ecs.system(Position)
+    def move(e, p):
+        p.x += 1
+
+    e = ecs.entity("E", [Position(0, 0)])
+
+    for frame in range(3):
+        # The frame runs on a native thread while other tasks keep going
+        pending = ecs.progress_async(1 / 60)
+        await asyncio.gather(pending, log_lines())
+        print(e.get(Position))
+
+    # Using the world before the frame is done raises an error
+    pending = ecs.progress_async()
+    try:
+        ecs.lookup("E")
+    except RuntimeError as err:
+        print(err)
+    pending.result()
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,49 @@
+import flecs
+import numpy as np
+from dataclasses import dataclass
+
+@dataclass
+class Features:
+    values: np.ndarray
+
+@dataclass
+class Action:
+    logits: np.ndarray
+
+def main():
+    ecs = flecs.World()
+
+    weights = np.random.rand(4, 2).astype(np.float32)
+
+    # Called once per frame with a (num_agents, 4) batch instead of once per agent
+    @ecs.system_batch(Features, Action, "Agent", input_field="values", output_field="logits")
+    def policy(batch):
+        return batch @ weights
+
+    for i in range(8):
+        ecs.entity(f"Agent{i}", [
+            "Agent",
+            Features(np.random.rand(4).astype(np.float32)),
+            Action(None)])
+
+    ecs.progress()
+
+    for i in range(8):
+        print(ecs.lookup(f"Agent{i}").get(Action))
+
+    # Native components are gathered and scattered without Python objects
+    ecs.component("Observation", {"x": "f32", "y": "f32"})
+    ecs.component("Steering", {"dx": "f32", "dy": "f32"})
+
+    @ecs.system_batch("Observation", "Steering")
+    def steer(batch):
+        return -batch
+
+    e = ecs.entity("Native")
+    e.set("Observation", {"x": 1.0, "y": 2.0})
+    e.set("Steering", {})
+    ecs.progress()
+    print(e.get("Steering"))
+
+if __name__ == "__main__":
+    main()
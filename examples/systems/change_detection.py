@@ -0,0 +1,45 @@
+import flecs
+from dataclasses import dataclass
+
+@dataclass
+class Position:
+    x: float
+    y: float
+
+@dataclass
+class Goal:
+    x: float
+    y: float
+
+def main():
+    ecs = flecs.World()
+
+    # Only runs for tables in which a Position or Goal changed since the last frame
+    @ecs.system(Position, Goal, changed_only=True)
+    def replan(e, pos, goal):
+        print(f"{e.name()} replanning from {pos} to {goal}")
+
+    ecs.entity("e1", [Position(10, 20), Goal(0, 0)])
+    ecs.entity("e2", [Position(30, 40), Goal(5, 5)])
+
+    ecs.progress() # Both entities are new, system runs
+    ecs.progress() # Nothing changed, system is skipped
+
+    # Writes through a tracked proxy flag the component as modified
+    pos = ecs.lookup("e1").get(Position, track=True)
+    pos.x = 11
+    ecs.progress() # e1's table changed, system runs
+
+    # Mutating the object directly requires an explicit modified()
+    e2 = ecs.lookup("e2")
+    e2.get(Goal).x = 6
+    e2.modified(Goal)
+    ecs.progress()
+
+    query = ecs.query(Position, changed_only=True)
+    for e, pos in query:
+        print(f"{e.name()} {pos}")
+    print(query.changed())
+
+if __name__ == "__main__":
+    main()
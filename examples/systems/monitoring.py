@@ -0,0 +1,45 @@
+import flecs
+import json
+import threading
+import time
+import urllib.request
+from dataclasses import dataclass
+
+@dataclass
+class Position:
+    x: float
+    y: float
+
+def main():
+    ecs = flecs.World()
+
+    # Also serves the flecs explorer (https://www.flecs.dev/explorer) on this port
+    ecs.enable_rest(27750, sample_interval=0.5)
+
+    @ecs.system(Position)
+    def drift(e, p):
+        p.x += 1
+
+    for i in range(100):
+        ecs.entity(f"E{i}", [Position(0, 0)])
+
+    # Requests are answered from within progress(), so keep the world ticking.
+    # progress() releases the GIL, letting this thread make requests meanwhile.
+    running = True
+    def simulate():
+        while running:
+            ecs.progress()
+            time.sleep(1 / 60)
+    simulation = threading.Thread(target=simulate)
+    simulation.start()
+
+    time.sleep(1)
+    url = "http://127.0.0.1:27750/component/WorldMetrics?component=WorldMetrics"
+    with urllib.request.urlopen(url) as response:
+        print(json.loads(response.read()))
+
+    running = False
+    simulation.join()
+
+if __name__ == "__main__":
+    main()
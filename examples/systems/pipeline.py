@@ -0,0 +1,42 @@
+import flecs
+from dataclasses import dataclass
+
+@dataclass
+class Plan:
+    steps: int
+
+def main():
+    ecs = flecs.World()
+
+    # Custom phases run in order of their dependencies
+    perceive = ecs.phase("Perceive", depends_on=flecs.PreUpdate)
+    think = ecs.phase("Think", depends_on=perceive)
+
+    @ecs.system(Plan, phase=perceive)
+    def sense(e, plan):
+        print(f"{e.name()} senses")
+
+    # Runs at most every 0.25 seconds of simulated time
+    @ecs.system(Plan, phase=think, interval=0.25)
+    def replan(e, plan):
+        plan.steps += 1
+        print(f"{e.name()} replanned {plan.steps} times")
+
+    # Runs on every 4th tick of a shared timer
+    second = ecs.timer(1.0)
+    @ecs.system(Plan, rate=4, tick_source=second)
+    def report(e, plan):
+        print(f"{e.name()} report")
+
+    ecs.entity("Agent", [Plan(0)])
+
+    for _ in range(10):
+        ecs.progress(0.1)
+
+    # Systems and phases can be toggled at runtime
+    replan.system.disable()
+    think.disable()
+    ecs.progress(0.1)
+
+if __name__ == "__main__":
+    main()
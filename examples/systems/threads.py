@@ -0,0 +1,37 @@
+import flecs
+import sys
+from dataclasses import dataclass
+
+@dataclass
+class Position:
+    x: float
+    y: float
+
+@dataclass
+class Velocity:
+    x: float
+    y: float
+
+def main():
+    ecs = flecs.World()
+
+    # On a free-threaded build (python3.13t) Python systems run in parallel on
+    # flecs worker threads; with the GIL they still run, one worker at a time.
+    ecs.set_threads(4)
+
+    @ecs.system(Position, Velocity, multi_threaded=True)
+    def move(e, p, v):
+        p.x += v.x
+        p.y += v.y
+
+    for i in range(1000):
+        ecs.entity(f"E{i}", [Position(0, 0), Velocity(i, 1)])
+
+    ecs.progress()
+    print(ecs.lookup("E10").get(Position))
+
+    gil = getattr(sys, "_is_gil_enabled", lambda: True)()
+    print("GIL enabled:", gil)
+
+if __name__ == "__main__":
+    main()
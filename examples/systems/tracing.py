@@ -0,0 +1,33 @@
+import flecs
+from dataclasses import dataclass
+
+@dataclass
+class Velocity:
+    x: float
+    y: float
+
+def main():
+    ecs = flecs.World()
+
+    @ecs.system(Velocity, phase=flecs.PreUpdate)
+    def damp(e, v):
+        v.x *= 0.9
+        v.y *= 0.9
+
+    @ecs.system_iter(Velocity)
+    def report(it, velocities):
+        sum(v.x for v in velocities)
+
+    for i in range(1000):
+        ecs.entity(f"Body{i}").set(Velocity(i, -i))
+
+    ecs.enable_tracing()
+    for frame in range(60):
+        ecs.progress(1 / 60)
+    ecs.enable_tracing(False)
+
+    # Open in chrome://tracing or ui.perfetto.dev
+    ecs.dump_trace("frames.json")
+
+if __name__ == "__main__":
+    main()
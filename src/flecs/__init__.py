@@ -1,5 +1,14 @@
 from __future__ import annotations
 
-from ._core import __doc__, __version__, World, Entity, Query, Iterator, OnAdd, OnRemove, OnSet
+from ._core import __doc__, __version__, World, Entity, Query, Iterator, TrackedComponent, TagSet, View, Frame, OnAdd, OnRemove, OnSet
+from ._core import OnStart, PreFrame, OnLoad, PostLoad, PreUpdate, OnUpdate, OnValidate, PostUpdate, PreStore, OnStore, PostFrame
 
-__all__ = ["__doc__", "__version__", "World", "Entity", "Query", "Iterator", "OnAdd, OnRemove, OnSet"]
+__all__ = ["__doc__", "__version__", "World", "Entity", "Query", "Iterator", "TrackedComponent", "TagSet", "View", "Frame", "OnAdd", "OnRemove", "OnSet",
+           "OnStart", "PreFrame", "OnLoad", "PostLoad", "PreUpdate", "OnUpdate", "OnValidate", "PostUpdate", "PreStore", "OnStore", "PostFrame"]
+
+# Shared memory exports are only available on POSIX platforms
+try:
+    from ._core import SharedView
+    __all__.append("SharedView")
+except ImportError:
+    pass
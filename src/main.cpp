@@ -4,9 +4,30 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <deque>
 #include <set>
 #include <unordered_map>
 #include <typeindex> // For std::type_index
+#include <cstring>
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <thread>
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <pybind11/numpy.h>
 
 #define STRINGIFY(x) #x
@@ -22,20 +43,372 @@ struct GraphExportData {
     std::vector<int64_t> edge_relations;
     std::vector<std::string> relation_names;
     std::map<int64_t, int> id_to_index;
+    // Numeric fields of native pair components, row major (num_edges x edge_attr_names)
+    std::vector<std::string> edge_attr_names;
+    std::vector<float> edge_attr;
 };
 
 class PyQueryIterator;
+struct SystemBatchSpec;
+class MutationJournal;
+struct DeltaTracker;
+void journal_deleted(const ecs_world_t* world, ecs_entity_t e);
+void record_toggle(const ecs_world_t* world, ecs_entity_t e, ecs_id_t id, bool enabled);
+
+// Python objects and callbacks of a world. Each PyWorld owns one and flecs callbacks
+// reach it through the binding context of their world, so worlds in one process
+// don't share entity ids.
+struct BindingState : std::enable_shared_from_this<BindingState> {
+    // Each (non-tag) component on an entity is mapped to a py::object
+    // This allows arbitrary Python classes/variables (such as neural networks) as component fields
+    std::map<flecs::id_t, std::map<flecs::id_t, py::object>> component_objects;
+    std::vector<py::object> observer_callbacks;
+    std::deque<PyQueryIterator> observer_queries;
+    std::vector<py::object> system_callbacks;
+    std::vector<py::object> observer_iter_callbacks;
+    std::vector<py::object> system_iter_callbacks;
+    std::vector<bool> system_changed_only;
+    std::vector<bool> system_track_writes;
+    // Arguments of a per-entity system: the entity and one object or None per term
+    std::vector<size_t> system_arities;
+    std::vector<bool> system_iter_changed_only;
+    std::vector<py::object> observer_batch_callbacks;
+    std::vector<py::object> system_batch_callbacks;
+    std::vector<SystemBatchSpec> system_batch_specs;
+    // Journal of the world, if one was started
+    MutationJournal* journal = nullptr;
+    // Change log of world.diff, once it was called
+    DeltaTracker* delta = nullptr;
+    // Asynchronous frames of the world that haven't finished
+    std::atomic<int> async_frames_in_flight{0};
+    // Frames run by progress(), which releases the GIL while the frame runs
+    std::atomic<int> frames_in_progress{0};
+    // Counts Entity.enable/disable(component) calls, which emit no event. Memoized
+    // queries evaluated before the last toggle are evaluated again.
+    std::atomic<uint64_t> toggle_version{0};
+    // Spans of the world are recorded while tracing is set. Spans that started
+    // before trace_since belong to an earlier enable_tracing and aren't dumped.
+    std::atomic<bool> tracing{false};
+    std::atomic<int64_t> trace_since{0};
+    // Cleared when the world starts shutting down. Objects that can outlive the
+    // world hold the state and check this before they touch it.
+    bool alive = true;
+    
+    void clear();
+    
+    // Free-threaded interpreters can run Python systems on flecs worker threads, so the
+    // component store and callback registries are guarded by a mutex. With the GIL the
+    // lock is empty. Python callbacks are never invoked while it is held.
+#ifdef Py_GIL_DISABLED
+    std::recursive_mutex mutex;
+#endif
+};
+
+BindingState& binding_state(const ecs_world_t* world) {
+    return *static_cast<BindingState*>(ecs_get_binding_ctx(ecs_get_world(world)));
+}
+
+struct BindingStateLock {
+#ifdef Py_GIL_DISABLED
+    std::lock_guard<std::recursive_mutex> lock;
+    BindingStateLock(BindingState& state) : lock(state.mutex) {}
+#else
+    BindingStateLock(BindingState&) {}
+#endif
+};
+
+// Deletes an observer once the Python object that created it is dropped. If the
+// world was destroyed first, its cleanup already deleted the observer.
+struct ObserverHandle {
+    std::shared_ptr<BindingState> state;
+    ecs_world_t* world;
+    ecs_entity_t observer;
+    
+    ObserverHandle(std::shared_ptr<BindingState> s, ecs_world_t* w, ecs_entity_t o) : state(s), world(w), observer(o) {}
+    ObserverHandle(const ObserverHandle&) = delete;
+    ObserverHandle& operator=(const ObserverHandle&) = delete;
+    
+    ~ObserverHandle() {
+        if (state->alive) {
+            ecs_delete(world, observer);
+        }
+    }
+};
+
+// Stored Python object of a component, empty if the entity doesn't have one
+py::object store_get(const ecs_world_t* world, ecs_entity_t e, ecs_id_t id) {
+    BindingState& state = binding_state(world);
+    BindingStateLock lock(state);
+    auto stored = state.component_objects.find(e);
+    if (stored == state.component_objects.end()) {
+        return py::object();
+    }
+    auto found = stored->second.find(id);
+    return found == stored->second.end() ? py::object() : found->second;
+}
+
+// The replaced object is released after unlocking, its __del__ may use the world
+void store_set(const ecs_world_t* world, ecs_entity_t e, ecs_id_t id, py::object obj) {
+    BindingState& state = binding_state(world);
+    py::object old;
+    {
+        BindingStateLock lock(state);
+        py::object& slot = state.component_objects[e][id];
+        old = std::move(slot);
+        slot = std::move(obj);
+    }
+}
+
+void store_erase(const ecs_world_t* world, ecs_entity_t e, ecs_id_t id) {
+    BindingState& state = binding_state(world);
+    py::object old;
+    {
+        BindingStateLock lock(state);
+        auto stored = state.component_objects.find(e);
+        if (stored == state.component_objects.end()) {
+            return;
+        }
+        auto found = stored->second.find(id);
+        if (found != stored->second.end()) {
+            old = std::move(found->second);
+            stored->second.erase(found);
+        }
+    }
+}
+
+// Copy a registry entry so that systems can be registered while others run
+template <typename T>
+bool registry_get(BindingState& state, const std::vector<T>& registry, size_t index, T& entry) {
+    BindingStateLock lock(state);
+    if (index >= registry.size()) {
+        return false;
+    }
+    entry = registry[index];
+    return true;
+}
+
+// Python component types are registered as native components so that flecs
+// can track changes to their columns. The column only holds a borrowed pointer,
+// the object itself is owned by the component store of the world.
+struct PyComponentRef {
+    PyObject* object;
+};
+
+void PyComponentRefCtor(void *ptr, int32_t count, const ecs_type_info_t *type_info) {
+    memset(ptr, 0, static_cast<size_t>(count) * static_cast<size_t>(type_info->size));
+}
+
+// Get or create the component entity for a Python type
+flecs::entity py_component_entity(flecs::world world, const std::string& type_name) {
+    flecs::entity component_entity = world.entity(type_name.c_str());
+    ecs_entity_t id = component_entity.id();
+    
+    if (!ecs_has_id(world, id, ecs_id(EcsComponent))) {
+        // flecs can't give a size to an id that entities already have
+        if (ecs_id_in_use(world, id) || ecs_id_in_use(world, ecs_pair(id, EcsWildcard))) {
+            throw std::runtime_error("Can't use " + type_name + " as a Python component, it is already used as a tag");
+        }
+        ecs_component_desc_t desc = {};
+        desc.entity = component_entity.id();
+        desc.type.size = sizeof(PyComponentRef);
+        desc.type.alignment = alignof(PyComponentRef);
+        ecs_component_init(world, &desc);
+        
+        ecs_type_hooks_t hooks = {};
+        hooks.ctor = PyComponentRefCtor;
+        ecs_set_hooks_id(world, component_entity.id(), &hooks);
+    } else {
+        const ecs_type_info_t* type_info = ecs_get_type_info(world, id);
+        if (!type_info || type_info->hooks.ctor != PyComponentRefCtor) {
+            throw std::runtime_error("Can't use " + type_name + " as a Python component, it is already a native component or tag");
+        }
+    }
+    
+    return component_entity;
+}
+
+flecs::entity py_component_entity(flecs::world world, py::handle py_type) {
+    std::string type_name = py::str(py_type.attr("__name__"));
+    return py_component_entity(world, type_name);
+}
+
+// Check if an id is a Python component column (holds a PyComponentRef)
+bool is_py_component(ecs_world_t* world, ecs_id_t id) {
+    const ecs_type_info_t* type_info = ecs_get_type_info(world, id);
+    return type_info && type_info->hooks.ctor == PyComponentRefCtor;
+}
+
+// Sparse and non-fragmenting components aren't stored in table columns. Query
+// fields for them have to be read per row with ecs_field_at.
+bool is_sparse_id(ecs_world_t* world, ecs_id_t id) {
+    ecs_entity_t component = ECS_IS_PAIR(id) ? ecs_pair_first(world, id) : id;
+    return ecs_has_id(world, component, EcsSparse) || ecs_has_id(world, component, EcsDontFragment);
+}
+
+// Native components are plain structs described with the flecs meta addon.
+// Their fields are primitive values that can be read and compared in C++.
+struct NativeField {
+    std::string name;
+    ecs_entity_t type;
+    int32_t offset;
+};
+
+// Map a field type name to the flecs primitive type
+const std::map<std::string, ecs_entity_t>& native_primitives() {
+    static const std::map<std::string, ecs_entity_t> primitives = {
+        {"bool", ecs_id(ecs_bool_t)},
+        {"i8", ecs_id(ecs_i8_t)}, {"i16", ecs_id(ecs_i16_t)},
+        {"i32", ecs_id(ecs_i32_t)}, {"i64", ecs_id(ecs_i64_t)},
+        {"u8", ecs_id(ecs_u8_t)}, {"u16", ecs_id(ecs_u16_t)},
+        {"u32", ecs_id(ecs_u32_t)}, {"u64", ecs_id(ecs_u64_t)},
+        {"f32", ecs_id(ecs_f32_t)}, {"f64", ecs_id(ecs_f64_t)},
+        {"entity", ecs_id(ecs_entity_t)}
+    };
+    return primitives;
+}
+
+ecs_entity_t native_primitive_type(const std::string& type_name) {
+    auto it = native_primitives().find(type_name);
+    if (it == native_primitives().end()) {
+        throw std::runtime_error("Unknown native field type: " + type_name);
+    }
+    return it->second;
+}
+
+std::string native_primitive_name(ecs_entity_t type) {
+    for (const auto& [name, primitive] : native_primitives()) {
+        if (primitive == type) {
+            return name;
+        }
+    }
+    throw std::runtime_error("Unsupported native field type: " + std::to_string(type));
+}
+
+// Get the fields of a native component, empty if the component has no struct info
+std::vector<NativeField> native_fields(ecs_world_t* world, ecs_entity_t component) {
+    std::vector<NativeField> fields;
+    const EcsStruct* st = ecs_get(world, component, EcsStruct);
+    if (!st) {
+        return fields;
+    }
+    
+    const ecs_member_t* members = ecs_vec_first_t(&st->members, ecs_member_t);
+    for (int32_t i = 0; i < ecs_vec_count(&st->members); i++) {
+        fields.push_back({members[i].name, members[i].type, members[i].offset});
+    }
+    return fields;
+}
+
+NativeField native_field(ecs_world_t* world, ecs_entity_t component, const std::string& field_name) {
+    for (const NativeField& field : native_fields(world, component)) {
+        if (field.name == field_name) {
+            return field;
+        }
+    }
+    throw std::runtime_error("Native component has no field: " + field_name);
+}
+
+double native_field_get(const NativeField& field, const void* ptr) {
+    const char* data = static_cast<const char*>(ptr) + field.offset;
+    if (field.type == ecs_id(ecs_f32_t)) return *reinterpret_cast<const float*>(data);
+    if (field.type == ecs_id(ecs_f64_t)) return *reinterpret_cast<const double*>(data);
+    if (field.type == ecs_id(ecs_i8_t)) return *reinterpret_cast<const int8_t*>(data);
+    if (field.type == ecs_id(ecs_i16_t)) return *reinterpret_cast<const int16_t*>(data);
+    if (field.type == ecs_id(ecs_i32_t)) return *reinterpret_cast<const int32_t*>(data);
+    if (field.type == ecs_id(ecs_i64_t)) return static_cast<double>(*reinterpret_cast<const int64_t*>(data));
+    if (field.type == ecs_id(ecs_u8_t)) return *reinterpret_cast<const uint8_t*>(data);
+    if (field.type == ecs_id(ecs_u16_t)) return *reinterpret_cast<const uint16_t*>(data);
+    if (field.type == ecs_id(ecs_u32_t)) return *reinterpret_cast<const uint32_t*>(data);
+    if (field.type == ecs_id(ecs_u64_t)) return static_cast<double>(*reinterpret_cast<const uint64_t*>(data));
+    if (field.type == ecs_id(ecs_entity_t)) return static_cast<double>(*reinterpret_cast<const ecs_entity_t*>(data));
+    if (field.type == ecs_id(ecs_bool_t)) return *reinterpret_cast<const bool*>(data) ? 1.0 : 0.0;
+    throw std::runtime_error("Unsupported native field type for field: " + field.name);
+}
+
+void native_field_set(const NativeField& field, void* ptr, py::handle value) {
+    char* data = static_cast<char*>(ptr) + field.offset;
+    if (field.type == ecs_id(ecs_f32_t)) *reinterpret_cast<float*>(data) = value.cast<float>();
+    else if (field.type == ecs_id(ecs_f64_t)) *reinterpret_cast<double*>(data) = value.cast<double>();
+    else if (field.type == ecs_id(ecs_i8_t)) *reinterpret_cast<int8_t*>(data) = value.cast<int8_t>();
+    else if (field.type == ecs_id(ecs_i16_t)) *reinterpret_cast<int16_t*>(data) = value.cast<int16_t>();
+    else if (field.type == ecs_id(ecs_i32_t)) *reinterpret_cast<int32_t*>(data) = value.cast<int32_t>();
+    else if (field.type == ecs_id(ecs_i64_t)) *reinterpret_cast<int64_t*>(data) = value.cast<int64_t>();
+    else if (field.type == ecs_id(ecs_u8_t)) *reinterpret_cast<uint8_t*>(data) = value.cast<uint8_t>();
+    else if (field.type == ecs_id(ecs_u16_t)) *reinterpret_cast<uint16_t*>(data) = value.cast<uint16_t>();
+    else if (field.type == ecs_id(ecs_u32_t)) *reinterpret_cast<uint32_t*>(data) = value.cast<uint32_t>();
+    else if (field.type == ecs_id(ecs_u64_t)) *reinterpret_cast<uint64_t*>(data) = value.cast<uint64_t>();
+    else if (field.type == ecs_id(ecs_entity_t)) *reinterpret_cast<ecs_entity_t*>(data) = value.cast<ecs_entity_t>();
+    else if (field.type == ecs_id(ecs_bool_t)) *reinterpret_cast<bool*>(data) = value.cast<bool>();
+    else throw std::runtime_error("Unsupported native field type for field: " + field.name);
+}
+
+void native_field_set_double(const NativeField& field, void* ptr, double value) {
+    char* data = static_cast<char*>(ptr) + field.offset;
+    if (field.type == ecs_id(ecs_f32_t)) *reinterpret_cast<float*>(data) = static_cast<float>(value);
+    else if (field.type == ecs_id(ecs_f64_t)) *reinterpret_cast<double*>(data) = value;
+    else if (field.type == ecs_id(ecs_i8_t)) *reinterpret_cast<int8_t*>(data) = static_cast<int8_t>(value);
+    else if (field.type == ecs_id(ecs_i16_t)) *reinterpret_cast<int16_t*>(data) = static_cast<int16_t>(value);
+    else if (field.type == ecs_id(ecs_i32_t)) *reinterpret_cast<int32_t*>(data) = static_cast<int32_t>(value);
+    else if (field.type == ecs_id(ecs_i64_t)) *reinterpret_cast<int64_t*>(data) = static_cast<int64_t>(value);
+    else if (field.type == ecs_id(ecs_u8_t)) *reinterpret_cast<uint8_t*>(data) = static_cast<uint8_t>(value);
+    else if (field.type == ecs_id(ecs_u16_t)) *reinterpret_cast<uint16_t*>(data) = static_cast<uint16_t>(value);
+    else if (field.type == ecs_id(ecs_u32_t)) *reinterpret_cast<uint32_t*>(data) = static_cast<uint32_t>(value);
+    else if (field.type == ecs_id(ecs_u64_t)) *reinterpret_cast<uint64_t*>(data) = static_cast<uint64_t>(value);
+    else if (field.type == ecs_id(ecs_entity_t)) *reinterpret_cast<ecs_entity_t*>(data) = static_cast<ecs_entity_t>(value);
+    else if (field.type == ecs_id(ecs_bool_t)) *reinterpret_cast<bool*>(data) = value != 0.0;
+    else throw std::runtime_error("Unsupported native field type for field: " + field.name);
+}
 
-// These fields will eventually be refactored to PyWorld: for now just use one world!...
+py::object native_field_object(const NativeField& field, const void* ptr) {
+    double value = native_field_get(field, ptr);
+    if (field.type == ecs_id(ecs_f32_t) || field.type == ecs_id(ecs_f64_t)) {
+        return py::float_(value);
+    }
+    if (field.type == ecs_id(ecs_bool_t)) {
+        return py::bool_(value != 0.0);
+    }
+    if (field.type == ecs_id(ecs_i64_t)) {
+        return py::int_(*reinterpret_cast<const int64_t*>(static_cast<const char*>(ptr) + field.offset));
+    }
+    if (field.type == ecs_id(ecs_u64_t) || field.type == ecs_id(ecs_entity_t)) {
+        return py::int_(*reinterpret_cast<const uint64_t*>(static_cast<const char*>(ptr) + field.offset));
+    }
+    return py::int_(static_cast<int64_t>(value));
+}
+
+// Declare a native component from a {field: type} dictionary with the meta addon
+flecs::entity init_native_component(flecs::world world, const std::string& name, py::dict fields) {
+    flecs::entity component = world.entity(name.c_str());
+    
+    std::vector<std::string> field_names;
+    std::vector<ecs_entity_t> field_types;
+    for (auto item : fields) {
+        field_names.push_back(py::str(item.first));
+        field_types.push_back(native_primitive_type(py::str(item.second)));
+    }
+    if (field_names.size() > ECS_MEMBER_DESC_CACHE_SIZE) {
+        throw std::runtime_error("Too many fields for native component: " + name);
+    }
+    
+    ecs_struct_desc_t desc = {};
+    desc.entity = component.id();
+    for (size_t i = 0; i < field_names.size(); i++) {
+        desc.members[i].name = field_names[i].c_str();
+        desc.members[i].type = field_types[i];
+    }
+    ecs_struct_init(world, &desc);
+    
+    return component;
+}
 
-// Each (non-tag) component on an entity is mapped to a py::object
-// This allows arbitrary Python classes/variables (such as neural networks) as component fields
-static std::map<flecs::id_t, std::map<flecs::id_t, py::object>> flecs_component_pyobject;
-static std::vector<py::object> observer_callbacks;
-static std::vector<PyQueryIterator> observer_queries;
-static std::vector<py::object> system_callbacks;
-static std::vector<py::object> observer_iter_callbacks;
-static std::vector<py::object> system_iter_callbacks;
+// Field values of a native component (or native pair) as a dictionary
+py::dict native_values(ecs_world_t* world, ecs_id_t id, const void* ptr) {
+    py::dict values;
+    for (const NativeField& field : native_fields(world, ecs_get_typeid(world, id))) {
+        values[py::str(field.name)] = native_field_object(field, ptr);
+    }
+    return values;
+}
 
 class PyEntity {
 public:
@@ -78,8 +451,32 @@ public:
     
     // Delete entity
     void destroy() { 
+        ecs_world_t* world = entity.world();
+        ecs_entity_t id = entity.id();
         entity.destruct(); 
+        journal_deleted(world, id);
+    }
+
+    // Enable or disable the entity, disabled systems and phases don't run
+    PyEntity* enable() {
+        ecs_enable(entity.world(), entity.id(), true);
+        return this;
+    }
+
+    PyEntity* disable() {
+        ecs_enable(entity.world(), entity.id(), false);
+        return this;
+    }
+
+    bool is_enabled() const {
+        return !entity.has(flecs::Disabled);
     }
+    
+    // Toggle a component or tag with the CanToggle trait. The entity stays in its
+    // table, queries skip it while the component is disabled.
+    PyEntity* enable(py::object component);
+    PyEntity* disable(py::object component);
+    bool is_enabled(py::object component) const;
 
 
     PyEntity* add_trait(const std::string& trait_name) {
@@ -98,6 +495,19 @@ public:
         else if (trait_name == "Inherit") {
             entity.add(flecs::OnInstantiate, flecs::Inherit);
         }
+        // Storage traits must be added before the component is used
+        else if (trait_name == "Sparse") {
+            entity.add(flecs::Sparse);
+        }
+        else if (trait_name == "DontFragment") {
+            entity.add(flecs::DontFragment);
+        }
+        else if (trait_name == "CanToggle") {
+            entity.add(flecs::CanToggle);
+        }
+        else if (trait_name == "Union") {
+            entity.add(flecs::Union);
+        }
         else {
             throw std::runtime_error("Unknown trait: " + trait_name);
         }
@@ -143,18 +553,12 @@ public:
     PyEntity* add_relationship(const std::string& relation_name, py::object py_component_instance) {
         flecs::entity relation = entity.world().entity(relation_name.c_str());
         
-        // Get the component type name
-        py::object py_type = py::type::of(py_component_instance);
-        std::string component_type_name = py::str(py_type.attr("__name__"));
-        
         // Get or create the component entity
-        flecs::entity component_entity = entity.world().entity(component_type_name.c_str());
-        
-        // Store the Python object
-        flecs_component_pyobject[entity.id()][component_entity.id()] = py_component_instance;
+        py::object py_type = py::type::of(py_component_instance);
+        flecs::entity component_entity = py_component_entity(entity.world(), py_type);
         
-        // Add the relationship
-        entity.add(relation, component_entity);
+        // The pair takes the component's type, so the object is stored under the pair id
+        set_pair_object(ecs_pair(relation.id(), component_entity.id()), py_component_instance);
         
         return this;
     }
@@ -162,15 +566,10 @@ public:
     // Add a relationship with Python component as relation
     PyEntity* add_relationship(py::object py_component_instance, const std::string& target_name) {
         py::object py_type = py::type::of(py_component_instance);
-        std::string component_type_name = py::str(py_type.attr("__name__"));
-        
-        flecs::entity component_entity = entity.world().entity(component_type_name.c_str());
+        flecs::entity component_entity = py_component_entity(entity.world(), py_type);
         flecs::entity target = entity.world().entity(target_name.c_str());
         
-        // Store the Python object
-        flecs_component_pyobject[entity.id()][component_entity.id()] = py_component_instance;
-        
-        entity.add(component_entity, target);
+        set_pair_object(ecs_pair(component_entity.id(), target.id()), py_component_instance);
         
         return this;
     }
@@ -180,21 +579,47 @@ public:
         py::object py_rel_type = py::type::of(py_relation_instance);
         py::object py_tgt_type = py::type::of(py_target_instance);
         
-        std::string rel_type_name = py::str(py_rel_type.attr("__name__"));
-        std::string tgt_type_name = py::str(py_tgt_type.attr("__name__"));
+        flecs::entity rel_entity = py_component_entity(entity.world(), py_rel_type);
+        flecs::entity tgt_entity = py_component_entity(entity.world(), py_tgt_type);
         
-        flecs::entity rel_entity = entity.world().entity(rel_type_name.c_str());
-        flecs::entity tgt_entity = entity.world().entity(tgt_type_name.c_str());
-        
-        // Store the Python objects
-        flecs_component_pyobject[entity.id()][rel_entity.id()] = py_relation_instance;
-        flecs_component_pyobject[entity.id()][tgt_entity.id()] = py_target_instance;
-        
-        entity.add(rel_entity, tgt_entity);
+        // Pair data has the relation's type, the target instance is kept under its own id
+        set_pair_object(ecs_pair(rel_entity.id(), tgt_entity.id()), py_relation_instance);
+        store_set(entity.world(), entity.id(), tgt_entity.id(), py_target_instance);
         
         return this;
     }
     
+    // Store a Python object for a pair and point the pair column at it when the pair has data
+    void set_pair_object(ecs_id_t pair, py::object obj) {
+        store_set(entity.world(), entity.id(), pair, obj);
+        if (is_py_component(entity.world(), pair)) {
+            PyComponentRef ref = { obj.ptr() };
+            ecs_set_id(entity.world(), entity.id(), pair, sizeof(PyComponentRef), &ref);
+        } else {
+            ecs_add_id(entity.world(), entity.id(), pair);
+        }
+    }
+    
+    // Add a relationship with native data, e.g. add("Friend", bob, weight=0.8). A relation
+    // that isn't a component yet is declared as a native component from the keyword
+    // arguments (f32 for floats, i64 for ints, bool for bools).
+    PyEntity* set_relationship(py::object relation, py::object target, py::kwargs values);
+    
+    // Python object or native field values stored for a relationship pair
+    py::object relationship_value(ecs_entity_t relation, ecs_entity_t target) {
+        ecs_id_t pair_id = ecs_pair(relation, target);
+        if (py::object stored = store_get(entity.world(), entity.id(), pair_id)) {
+            return stored;
+        }
+        if (!is_py_component(entity.world(), pair_id)) {
+            const void* ptr = ecs_get_id(entity.world(), entity.id(), pair_id);
+            if (ptr) {
+                return native_values(entity.world(), pair_id, ptr);
+            }
+        }
+        return py::none();
+    }
+    
     // Overloaded add method that handles tags, relationships, and components
     PyEntity* add(const std::string& tag_or_relation_name) {
         // Single argument - treat as tag
@@ -350,6 +775,7 @@ public:
         flecs::entity target = entity.world().lookup(target_name.c_str());
         if (relation.is_valid() && target.is_valid()) {
             entity.remove(relation, target);
+            store_erase(entity.world(), entity.id(), ecs_pair(relation.id(), target.id()));
         }
     }
     
@@ -358,12 +784,14 @@ public:
         flecs::entity relation = entity.world().lookup(relation_name.c_str());
         if (relation.is_valid()) {
             entity.remove(relation, target.entity);
+            store_erase(entity.world(), entity.id(), ecs_pair(relation.id(), target.entity.id()));
         }
     }
     
     // Remove a relationship (entity, entity)
     void remove_relationship(PyEntity& relation, PyEntity& target) {
         entity.remove(relation.entity, target.entity);
+        store_erase(entity.world(), entity.id(), ecs_pair(relation.entity.id(), target.entity.id()));
     }
     
     // Remove a relationship (entity, string)
@@ -371,6 +799,7 @@ public:
         flecs::entity target = entity.world().lookup(target_name.c_str());
         if (target.is_valid()) {
             entity.remove(relation.entity, target);
+            store_erase(entity.world(), entity.id(), ecs_pair(relation.entity.id(), target.id()));
         }
     }
     
@@ -404,7 +833,7 @@ public:
             entity.remove(component_entity);
             
             // Remove the stored Python object
-            flecs_component_pyobject[entity.id()].erase(component_entity.id());
+            store_erase(entity.world(), entity.id(), component_entity.id());
         }
     }
 
@@ -444,49 +873,247 @@ public:
         flecs::entity target = entity.world().lookup(target_name.c_str());
         
         if (relation.is_valid() && target.is_valid()) {
-            // Try to get component data stored for this relationship pair
-            auto pair_id = ecs_pair(relation.id(), target.id());
-            if (flecs_component_pyobject[entity.id()].count(pair_id)) {
-                return flecs_component_pyobject[entity.id()][pair_id];
-            }
+            return relationship_value(relation.id(), target.id());
         }
         
         return py::none();
     }
+    
+    py::object get_relationship_component(py::object relation, py::object target);
 
     PyEntity* set_component_instance(py::object py_component_instance) {
         py::object py_type = py::type::of(py_component_instance);
-        std::string type_name = py::str(py_type.attr("__name__"));
         
         // Get or create the component entity
-        flecs::entity flecs_comp_id = entity.world().entity(type_name.c_str());
+        flecs::entity flecs_comp_id = py_component_entity(entity.world(), py_type);
         
         // Store the Python object
-        flecs_component_pyobject[entity.id()][flecs_comp_id.id()] = py_component_instance;
+        store_set(entity.world(), entity.id(), flecs_comp_id.id(), py_component_instance);
         
-        // Add the component using C API - use ecs_id() to get the component ID
-        ecs_add_id(entity.world(), entity.id(), flecs_comp_id.id());
+        // Write the column through ecs_set_id so the table is marked dirty and OnSet is emitted
+        PyComponentRef ref = { py_component_instance.ptr() };
+        ecs_set_id(entity.world(), entity.id(), flecs_comp_id.id(), sizeof(PyComponentRef), &ref);
         
         return this;
     }
 
-    // Get a Python component from the entity
-    py::object get_component(py::object py_component_type) {
+    // Flag a Python component as modified after mutating it in place
+    PyEntity* modified(py::object py_component_type) {
         std::string type_name = py::str(py_component_type.attr("__name__"));
-        
         flecs::entity flecs_comp_id = entity.world().lookup(type_name.c_str());
+        
+        if (flecs_comp_id.is_valid() && entity.has(flecs_comp_id)) {
+            ecs_modified_id(entity.world(), entity.id(), flecs_comp_id.id());
+        }
+        return this;
+    }
+
+    // Get a Python component from the entity
+    py::object get_component(py::object py_component_type, bool track = false);
+
+    // Set field values of a native component, fields that are not passed keep their value
+    PyEntity* set_native(const std::string& component_name, py::dict values) {
+        flecs::entity component = entity.world().lookup(component_name.c_str());
+        const ecs_type_info_t* type_info = component.is_valid() ? ecs_get_type_info(entity.world(), component.id()) : nullptr;
+        if (!type_info) {
+            throw std::runtime_error("Not a native component: " + component_name);
+        }
+        
+        std::vector<char> data(type_info->size, 0);
+        const void* current = ecs_get_id(entity.world(), entity.id(), component.id());
+        if (current) {
+            memcpy(data.data(), current, data.size());
+        }
+        
+        for (auto item : values) {
+            NativeField field = native_field(entity.world(), component.id(), py::str(item.first));
+            native_field_set(field, data.data(), item.second);
+        }
+        
+        ecs_set_id(entity.world(), entity.id(), component.id(), data.size(), data.data());
+        return this;
+    }
 
-        if (!flecs_comp_id.is_valid()) {
+    // Get the field values of a native component as a dictionary
+    py::object get_native(const std::string& component_name) {
+        flecs::entity component = entity.world().lookup(component_name.c_str());
+        if (!component.is_valid()) {
             return py::none();
         }
+        
+        const void* ptr = ecs_get_id(entity.world(), entity.id(), component.id());
+        if (!ptr) {
+            return py::none();
+        }
+        
+        return native_values(entity.world(), component.id(), ptr);
+    }
+};
 
-        if (flecs_component_pyobject[entity.id()].count(flecs_comp_id.id())) {
-            return flecs_component_pyobject[entity.id()][flecs_comp_id.id()];
+// Lightweight proxy that forwards attribute access to a Python component
+// and flags the component as modified whenever an attribute is written.
+// It holds the binding state of its world to tell when the world is gone.
+class PyTrackedComponent {
+public:
+    std::shared_ptr<BindingState> state;
+    ecs_world_t* world;
+    ecs_entity_t entity;
+    ecs_id_t component;
+    py::object object;
+    
+    PyTrackedComponent(ecs_world_t* w, ecs_entity_t e, ecs_id_t c, py::object obj)
+        : state(binding_state(w).shared_from_this()), world(w), entity(e), component(c), object(obj) {}
+    
+    py::object getattr(const std::string& name) {
+        return object.attr(name.c_str());
+    }
+    
+    void setattr(const std::string& name, py::object value) {
+        if (!state->alive) {
+            throw std::runtime_error("The world of this component was destroyed");
+        }
+        object.attr(name.c_str()) = value;
+        // The entity may have been deleted or lost the component since it was fetched
+        if (ecs_is_alive(world, entity) && ecs_has_id(world, entity, component)) {
+            ecs_modified_id(world, entity, component);
         }
-        return py::none();
     }
 };
 
+py::object PyEntity::get_component(py::object py_component_type, bool track) {
+    std::string type_name = py::str(py_component_type.attr("__name__"));
+    
+    flecs::entity flecs_comp_id = entity.world().lookup(type_name.c_str());
+
+    if (!flecs_comp_id.is_valid()) {
+        return py::none();
+    }
+
+    if (py::object component = store_get(entity.world(), entity.id(), flecs_comp_id.id())) {
+        if (track) {
+            return py::cast(PyTrackedComponent(entity.world(), entity.id(), flecs_comp_id.id(), component));
+        }
+        return component;
+    }
+    return py::none();
+}
+
+// Resolve an entity from a name, Entity, Python component type or id
+ecs_entity_t entity_from_object(flecs::world& world, py::handle obj) {
+    if (py::isinstance<py::str>(obj)) {
+        return world.entity(obj.cast<std::string>().c_str()).id();
+    } else if (py::isinstance<PyEntity>(obj)) {
+        return obj.cast<PyEntity>().entity.id();
+    } else if (py::isinstance<py::int_>(obj)) {
+        return obj.cast<ecs_entity_t>();
+    }
+    return py_component_entity(world, obj).id();
+}
+
+PyEntity* PyEntity::set_relationship(py::object relation, py::object target, py::kwargs values) {
+    flecs::world world = entity.world();
+    ecs_entity_t relation_id = entity_from_object(world, relation);
+    ecs_entity_t target_id = entity_from_object(world, target);
+    
+    if (!ecs_get_type_info(world, relation_id)) {
+        // flecs can't give a size to a relation that pairs already use as a tag
+        if (ecs_id_in_use(world, relation_id) || ecs_id_in_use(world, ecs_pair(relation_id, EcsWildcard))) {
+            throw std::runtime_error("Can't set data on " + std::string(flecs::entity(world, relation_id).path().c_str()) +
+                ", it is already used as a tag relationship");
+        }
+        py::dict fields;
+        for (auto item : values) {
+            if (py::isinstance<py::bool_>(item.second)) {
+                fields[item.first] = "bool";
+            } else if (py::isinstance<py::int_>(item.second)) {
+                fields[item.first] = "i64";
+            } else {
+                fields[item.first] = "f32";
+            }
+        }
+        const char* name = ecs_get_name(world, relation_id);
+        init_native_component(world, name ? name : std::to_string(relation_id), fields);
+    }
+    
+    ecs_id_t pair_id = ecs_pair(relation_id, target_id);
+    ecs_entity_t type_id = ecs_get_typeid(world, pair_id);
+    const ecs_type_info_t* type_info = ecs_get_type_info(world, pair_id);
+    if (!type_info || is_py_component(world, pair_id)) {
+        throw std::runtime_error("Relationship has no native data: " + std::string(flecs::entity(world, relation_id).path().c_str()));
+    }
+    
+    std::vector<char> data(type_info->size, 0);
+    const void* current = ecs_get_id(world, entity.id(), pair_id);
+    if (current) {
+        memcpy(data.data(), current, data.size());
+    }
+    for (auto item : values) {
+        NativeField field = native_field(world, type_id, py::str(item.first));
+        native_field_set(field, data.data(), item.second);
+    }
+    
+    ecs_set_id(world, entity.id(), pair_id, data.size(), data.data());
+    return this;
+}
+
+// Id of a toggleable component, tag or (relation, target) pair
+ecs_id_t toggle_id(flecs::world world, py::object component) {
+    ecs_id_t id;
+    if (py::isinstance<py::tuple>(component) && py::len(component) == 2) {
+        py::tuple pair = component.cast<py::tuple>();
+        id = ecs_pair(entity_from_object(world, pair[0]), entity_from_object(world, pair[1]));
+    } else {
+        id = entity_from_object(world, component);
+    }
+    ecs_entity_t first = ECS_IS_PAIR(id) ? ecs_pair_first(world, id) : id;
+    if (!ecs_has_id(world, first, EcsCanToggle)) {
+        throw std::runtime_error("Only components with the CanToggle trait can be enabled and disabled: " +
+            std::string(py::str(component)));
+    }
+    return id;
+}
+
+PyEntity* PyEntity::enable(py::object component) {
+    ecs_id_t id = toggle_id(entity.world(), component);
+    ecs_enable_id(entity.world(), entity.id(), id, true);
+    record_toggle(entity.world(), entity.id(), id, true);
+    return this;
+}
+
+PyEntity* PyEntity::disable(py::object component) {
+    ecs_id_t id = toggle_id(entity.world(), component);
+    ecs_enable_id(entity.world(), entity.id(), id, false);
+    record_toggle(entity.world(), entity.id(), id, false);
+    return this;
+}
+
+bool PyEntity::is_enabled(py::object component) const {
+    return ecs_is_enabled_id(entity.world(), entity.id(), toggle_id(entity.world(), component));
+}
+
+py::object PyEntity::get_relationship_component(py::object relation, py::object target) {
+    flecs::world world = entity.world();
+    return relationship_value(entity_from_object(world, relation), entity_from_object(world, target));
+}
+
+// flecs order_by callbacks don't carry a context, so the field to sort on is
+// set for the duration of ecs_query_iter, which is where cached queries sort.
+// PyQueryIterator::query_iter sets it; called from C, so it must not throw.
+static thread_local const NativeField* active_order_by_field = nullptr;
+
+int compare_native_field(ecs_entity_t e1, const void *ptr1, ecs_entity_t e2, const void *ptr2) noexcept {
+    if (active_order_by_field) {
+        try {
+            double v1 = native_field_get(*active_order_by_field, ptr1);
+            double v2 = native_field_get(*active_order_by_field, ptr2);
+            return (v1 > v2) - (v1 < v2);
+        } catch (...) {
+            // Unsupported field types fall back to entity order
+        }
+    }
+    return (e1 > e2) - (e1 < e2);
+}
+
 // This should eventually be refactored away for efficiency
 // it's mainly a verbose 'semantic representation' of query terms
 // that helped me to reason about what tuple relationships imply
@@ -624,8 +1251,7 @@ ecs_query_desc_t generate_query_from_args(py::args& args, flecs::world& world, s
                     term.relation_id = rel_entity.entity.id();
                 } else {
                     // Assume it's a component type
-                    std::string rel_name = py::str(relation.attr("__name__"));
-                    term.relation_id = world.entity(rel_name.c_str()).id();
+                    term.relation_id = py_component_entity(world, relation).id();
                 }
                 
                 // Parse target (second element)
@@ -650,8 +1276,7 @@ ecs_query_desc_t generate_query_from_args(py::args& args, flecs::world& world, s
                     term.target_id = tgt_entity.entity.id();
                 } else {
                     // Assume it's a component type
-                    std::string tgt_name = py::str(target.attr("__name__"));
-                    term.target_id = world.entity(tgt_name.c_str()).id();
+                    term.target_id = py_component_entity(world, target).id();
                 }
                 
                 // Create pair ID
@@ -701,8 +1326,7 @@ ecs_query_desc_t generate_query_from_args(py::args& args, flecs::world& world, s
                     term.relation_id = rel_entity.entity.id();
                 } else {
                     // Assume it's a component type
-                    std::string rel_name = py::str(relation.attr("__name__"));
-                    term.relation_id = world.entity(rel_name.c_str()).id();
+                    term.relation_id = py_component_entity(world, relation).id();
                 }
                 
                 // Parse target (second element)
@@ -727,8 +1351,7 @@ ecs_query_desc_t generate_query_from_args(py::args& args, flecs::world& world, s
                     term.target_id = tgt_entity.entity.id();
                 } else {
                     // Assume it's a component type
-                    std::string tgt_name = py::str(target.attr("__name__"));
-                    term.target_id = world.entity(tgt_name.c_str()).id();
+                    term.target_id = py_component_entity(world, target).id();
                 }
                 
                 // Create pair ID
@@ -753,8 +1376,7 @@ ecs_query_desc_t generate_query_from_args(py::args& args, flecs::world& world, s
                 term.is_tag = true;
             } else {
                 // Component
-                std::string component_name = py::str(comp_type.attr("__name__"));
-                term.id = world.entity(component_name.c_str()).id();
+                term.id = py_component_entity(world, comp_type).id();
                 term.is_tag = false;
                 non_tag_component_count++;
             }
@@ -820,6 +1442,37 @@ ecs_query_desc_t generate_query_from_args(py::args& args, flecs::world& world, s
     return desc;
 }
 
+// Enable flecs change detection for a query. Terms are read-only so that
+// iterating doesn't dirty its own tables, writes are flagged with modified().
+void enable_change_detection(ecs_query_desc_t& desc) {
+    desc.cache_kind = EcsQueryCacheAuto;
+    desc.flags |= EcsQueryDetectChanges;
+    for (int i = 0; i < 32 && ecs_term_is_initialized(&desc.terms[i]); ++i) {
+        if (desc.terms[i].inout == EcsInOutDefault || desc.terms[i].inout == EcsInOut) {
+            desc.terms[i].inout = EcsIn;
+        }
+    }
+}
+
+// Add an optional term for component on the parent of each entity. Cascade makes
+// the query iterate tables breadth-first, so parents are processed before children.
+void add_cascade_term(ecs_query_desc_t& desc, size_t term_index, ecs_entity_t component, ecs_entity_t relation) {
+    if (term_index >= 32) {
+        throw std::runtime_error("Too many query terms to add cascade term");
+    }
+    desc.terms[term_index].id = component;
+    desc.terms[term_index].src.id = EcsUp | EcsCascade;
+    desc.terms[term_index].trav = relation;
+    desc.terms[term_index].oper = EcsOptional;
+    desc.terms[term_index].inout = EcsIn;
+}
+
+// Payload of an event emitted with world.emit, which is the only caller that sets
+// the param of an event. Other events have no payload.
+py::object event_payload(const ecs_iter_t* it) {
+    return it->param ? py::reinterpret_borrow<py::object>(static_cast<PyObject*>(it->param)) : py::none();
+}
+
 class PyIterator {
 private:
     ecs_iter_t* it;
@@ -842,6 +1495,11 @@ public:
         return "";
     }
     
+    // Payload passed to world.emit, None for other events
+    py::object payload() const {
+        return event_payload(it);
+    }
+    
     // Return the actual event_id constant  
     ecs_entity_t event_id() const {
         return it->event_id;
@@ -893,14 +1551,169 @@ public:
         ecs_entity_t entity_id = it->entities[entity_index];
         ecs_id_t field_id = ecs_field_id(it, field);
         
-        if (flecs_component_pyobject[entity_id].count(field_id)) {
-            return flecs_component_pyobject[entity_id][field_id];
+        if (py::object stored = store_get(it->world, entity_id, field_id)) {
+            return stored;
         }
         
         return py::none();
     }
 };
 
+// Result set of a memoized query as id arrays. Observers on the ids of the query
+// terms, and on Disabled and Prefab, mark it invalid when entities gain or lose one
+// of them, since only then can the set of matches change. Toggling a CanToggle id
+// emits no event, the memo compares the toggle version of its world instead.
+// Component values are read when rows are yielded.
+struct QueryMemo {
+    bool valid = false;
+    uint64_t toggle_version = 0;
+    std::vector<ecs_entity_t> entities;
+    std::vector<ecs_entity_t> variables;
+    std::vector<ecs_id_t> field_ids;
+};
+
+void QueryMemoInvalidate(ecs_iter_t *it) {
+    (*static_cast<std::shared_ptr<QueryMemo>*>(it->ctx))->valid = false;
+}
+
+// Filter on a field of a native component, e.g. ("Health", "hp", "<", 10). Filters are
+// evaluated over the columns of each matched table, so only the rows that pass are
+// turned into Python values. Comparisons are done on doubles, except for f32 fields and
+// 64 bit integer fields (which don't fit in a double) that compare in their own type.
+// "in" compares integers.
+enum PredicateOp { PredLt, PredLe, PredGt, PredGe, PredEq, PredNe, PredBetween, PredIn };
+
+struct FieldPredicate {
+    int8_t field;
+    NativeField native;
+    size_t component_size;
+    PredicateOp op;
+    double lo = 0.0;
+    double hi = 0.0;
+    // Bounds for i64 fields, and for u64 and entity fields
+    int64_t int_lo = 0;
+    int64_t int_hi = 0;
+    uint64_t uint_lo = 0;
+    uint64_t uint_hi = 0;
+    // Bounds for f32 fields, see float_bound
+    float float_lo = 0.0f;
+    float float_hi = 0.0f;
+    // Sorted values for PredIn, u64 values are stored as their int64 bit pattern
+    std::vector<int64_t> set;
+};
+
+// Nearest float above (or below) a bound, so that comparing an f32 field with it
+// in float gives the same result as comparing the exact values
+float float_bound(double bound, bool up) {
+    if (std::isnan(bound) || std::isinf(bound)) {
+        return static_cast<float>(bound);
+    }
+    double max = std::numeric_limits<float>::max();
+    if (bound > max) {
+        return up ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::max();
+    }
+    if (bound < -max) {
+        return up ? -std::numeric_limits<float>::max() : -std::numeric_limits<float>::infinity();
+    }
+    float f = static_cast<float>(bound);
+    if (up && static_cast<double>(f) < bound) {
+        return std::nextafter(f, std::numeric_limits<float>::infinity());
+    }
+    if (!up && static_cast<double>(f) > bound) {
+        return std::nextafter(f, -std::numeric_limits<float>::infinity());
+    }
+    return f;
+}
+
+// Plain loops over a strided column that the compiler can vectorize
+template <typename T>
+void apply_predicate(const FieldPredicate& p, const char* base, size_t stride, int32_t count, uint8_t* mask) {
+    base += p.native.offset;
+    auto run = [&](auto test) {
+        for (int32_t i = 0; i < count; i++) {
+            T v;
+            memcpy(&v, base + i * stride, sizeof(T));
+            mask[i] &= static_cast<uint8_t>(test(v));
+        }
+    };
+    using Bound = std::conditional_t<std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> ||
+        std::is_same_v<T, float>, T, double>;
+    Bound lo, hi;
+    if constexpr (std::is_same_v<T, int64_t>) {
+        lo = p.int_lo;
+        hi = p.int_hi;
+    } else if constexpr (std::is_same_v<T, float>) {
+        lo = p.float_lo;
+        hi = p.float_hi;
+    } else if constexpr (std::is_same_v<T, uint64_t>) {
+        lo = p.uint_lo;
+        hi = p.uint_hi;
+    } else {
+        lo = p.lo;
+        hi = p.hi;
+    }
+    switch (p.op) {
+    case PredLt: run([lo](T v) { return static_cast<Bound>(v) < lo; }); break;
+    case PredLe: run([lo](T v) { return static_cast<Bound>(v) <= lo; }); break;
+    case PredGt: run([lo](T v) { return static_cast<Bound>(v) > lo; }); break;
+    case PredGe: run([lo](T v) { return static_cast<Bound>(v) >= lo; }); break;
+    case PredEq: run([lo](T v) { return static_cast<Bound>(v) == lo; }); break;
+    case PredNe: run([lo](T v) { return static_cast<Bound>(v) != lo; }); break;
+    case PredBetween: run([lo, hi](T v) { return static_cast<Bound>(v) >= lo && static_cast<Bound>(v) <= hi; }); break;
+    case PredIn: run([&p](T v) { return std::binary_search(p.set.begin(), p.set.end(), static_cast<int64_t>(v)); }); break;
+    }
+}
+
+void apply_predicate(const FieldPredicate& p, const char* base, size_t stride, int32_t count, uint8_t* mask) {
+    ecs_entity_t type = p.native.type;
+    if (type == ecs_id(ecs_f32_t)) apply_predicate<float>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_f64_t)) apply_predicate<double>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_i8_t)) apply_predicate<int8_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_i16_t)) apply_predicate<int16_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_i32_t)) apply_predicate<int32_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_i64_t)) apply_predicate<int64_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_u8_t)) apply_predicate<uint8_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_u16_t)) apply_predicate<uint16_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_u32_t)) apply_predicate<uint32_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_u64_t) || type == ecs_id(ecs_entity_t)) apply_predicate<uint64_t>(p, base, stride, count, mask);
+    else if (type == ecs_id(ecs_bool_t)) apply_predicate<bool>(p, base, stride, count, mask);
+    else throw std::runtime_error("Unsupported native field type for field: " + p.native.name);
+}
+
+// Rows of a query result that pass all predicates
+void select_rows(ecs_iter_t* it, const std::vector<FieldPredicate>& predicates, std::vector<int32_t>& selected) {
+    std::vector<uint8_t> mask(it->count, 1);
+    std::vector<char> gathered;
+    for (const FieldPredicate& p : predicates) {
+        if (!ecs_field_is_set(it, p.field)) {
+            std::fill(mask.begin(), mask.end(), 0);
+            break;
+        }
+        const char* base;
+        size_t stride = p.component_size;
+        if (is_sparse_id(it->real_world, ecs_field_id(it, p.field))) {
+            gathered.resize(p.component_size * it->count);
+            for (int32_t i = 0; i < it->count; i++) {
+                memcpy(gathered.data() + i * stride, ecs_field_at_w_size(it, stride, p.field, i), stride);
+            }
+            base = gathered.data();
+        } else {
+            base = static_cast<const char*>(ecs_field_w_size(it, p.component_size, p.field));
+            if (!ecs_field_is_self(it, p.field)) {
+                stride = 0;
+            }
+        }
+        apply_predicate(p, base, stride, it->count, mask.data());
+    }
+    
+    selected.clear();
+    for (int32_t i = 0; i < it->count; i++) {
+        if (mask[i]) {
+            selected.push_back(i);
+        }
+    }
+}
+
 class PyQueryIterator {
 private:
     flecs::world world;
@@ -911,20 +1724,339 @@ private:
     std::vector<int> var_indices;
 
     bool next_archetype = true;
+    // Only yield entities from tables that changed since the last iteration
+    bool changed_only = false;
+    // Native component field used to sort results
+    bool has_order_by = false;
+    NativeField order_by_field;
+    // Group to iterate when the query has group_by, 0 iterates all groups
+    uint64_t group_id = 0;
+    // Cached results, shared with the observers that invalidate them. The observers
+    // are deleted when the last copy of the query is dropped.
+    std::shared_ptr<QueryMemo> memo;
+    std::vector<std::shared_ptr<ObserverHandle>> memo_observers;
+    size_t memo_row = 0;
+    // Filters on native fields and the rows of the current table that pass them
+    std::vector<FieldPredicate> predicates;
+    std::vector<int32_t> selected;
     // Query iterator
     size_t i = 0;
     size_t current = 0;
     
-public:
-    PyQueryIterator(flecs::world& w, py::args args) : world(w) {
-        std::vector<std::string> var_names;
-        ecs_query_desc_t desc = generate_query_from_args(args, w, var_names, query_terms);
-        query = ecs_query_init(w, &desc);
-        for (std::string var_name : var_names) {
+    // Evaluate the query once and store each match as entity, variable and field ids
+    void evaluate_memo() {
+        memo->toggle_version = binding_state(world).toggle_version.load();
+        memo->entities.clear();
+        memo->variables.clear();
+        memo->field_ids.clear();
+        begin();
+        while (ecs_query_next(&it)) {
+            for (int row = 0; row < it.count; row++) {
+                memo->entities.push_back(it.entities[row]);
+                for (int var_index : var_indices) {
+                    memo->variables.push_back(var_index == 0 ? it.entities[row] : ecs_iter_get_var(&it, var_index));
+                }
+                for (size_t term_idx = 0; term_idx < query_terms.size(); term_idx++) {
+                    memo->field_ids.push_back(ecs_field_id(&it, static_cast<int8_t>(term_idx)));
+                }
+            }
+        }
+        memo->valid = true;
+    }
+    
+    // Id observed for a term of a memoized query, variables become wildcards
+    static ecs_id_t memo_watch_id(const ecs_term_t& term) {
+        auto ref_id = [](const ecs_term_ref_t& ref) -> ecs_entity_t {
+            return ref.id & EcsIsVariable ? EcsWildcard : ref.id & ~EcsTermRefFlags;
+        };
+        if (ECS_IS_PAIR(term.id)) {
+            return ecs_pair(ref_id(term.first), ref_id(term.second));
+        }
+        return term.id ? ref_id(term.first) : 0;
+    }
+    
+    bool memo_valid() const {
+        return memo->valid && memo->toggle_version == binding_state(world).toggle_version.load();
+    }
+    
+    void watch_memo() {
+        BindingState& state = binding_state(world);
+        // Disabling an entity or making it a prefab removes it from the results
+        std::vector<ecs_id_t> watched_ids = {EcsDisabled, EcsPrefab};
+        for (int8_t t = 0; t < query->term_count; t++) {
+            if (ecs_id_t watched = memo_watch_id(query->terms[t])) {
+                watched_ids.push_back(watched);
+            }
+        }
+        for (ecs_id_t watched : watched_ids) {
+            ecs_observer_desc_t desc = {};
+            desc.query.terms[0].id = watched;
+            desc.query.flags = EcsQueryMatchDisabled | EcsQueryMatchPrefab;
+            desc.events[0] = EcsOnAdd;
+            desc.events[1] = EcsOnRemove;
+            desc.callback = QueryMemoInvalidate;
+            desc.ctx = new std::shared_ptr<QueryMemo>(memo);
+            desc.ctx_free = [](void* ctx) {
+                delete static_cast<std::shared_ptr<QueryMemo>*>(ctx);
+            };
+            ecs_entity_t observer = ecs_observer_init(world, &desc);
+            memo_observers.push_back(std::make_shared<ObserverHandle>(state.shared_from_this(), world.c_ptr(), observer));
+        }
+    }
+    
+    // Python values for a match: variables, wildcard targets/relations and component
+    // objects. Each value is passed to append, callers decide what to collect them in.
+    template <typename Append>
+    void build_row(ecs_entity_t source, const ecs_entity_t* variables, const ecs_id_t* field_ids, Append&& append) {
+        // Create a PyEntity from $this flecs entity as the first argument
+        for (size_t v = 0; v < var_indices.size(); v++) {
+            append(py::cast(PyEntity(flecs::entity(world, variables[v]))));
+        }
+        
+        // Process each query term
+        for (size_t term_idx = 0; term_idx < query_terms.size(); term_idx++) {
+            const QueryTerm& term = query_terms[term_idx];
+            
+            if (term.is_relationship) {
+                if (term.is_wildcard_target || term.is_wildcard_relation) {
+                    // For wildcard relationships, we need to get the actual pair from the iterator
+                    ecs_id_t actual_id = field_ids[term_idx];
+                    
+                    if (ECS_IS_PAIR(actual_id)) {
+                        ecs_entity_t actual_relation = ecs_pair_first(world, actual_id);
+                        ecs_entity_t actual_target = ecs_pair_second(world, actual_id);
+                        
+                        if (term.is_wildcard_target) {
+                            // Return the actual target entity
+                            PyEntity target_entity(flecs::entity(world, actual_target));
+                            append(py::cast(target_entity));
+                        }
+                        
+                        if (term.is_wildcard_relation) {
+                            // Return the actual relation entity
+                            PyEntity relation_entity(flecs::entity(world, actual_relation));
+                            append(py::cast(relation_entity));
+                        }
+                        
+                        // Check if there's component data for this relationship
+                        if (py::object stored = store_get(world, source, actual_id)) {
+                            append(stored);
+                        }
+                    }
+                } else {
+                    // Specific relationship pair
+                    if (py::object stored = store_get(world, source, term.id)) {
+                        append(stored);
+                    }
+                }
+            } else if (!term.is_tag) {
+                // Regular component
+                if (py::object stored = store_get(world, source, term.id)) {
+                    append(stored);
+                }
+            }
+            // Tags don't add anything to the result tuple
+        }
+    }
+    
+    FieldPredicate parse_predicate(flecs::world& w, const ecs_query_desc_t& desc, py::object item) {
+        py::tuple spec = item.cast<py::tuple>();
+        if (spec.size() != 4) {
+            throw std::runtime_error("where filters must be (component, field, op, value) tuples");
+        }
+        
+        FieldPredicate p;
+        ecs_entity_t component = entity_from_object(w, spec[0]);
+        p.field = -1;
+        for (size_t t = 0; t < query_terms.size() && t < 32; t++) {
+            if (desc.terms[t].id == component && desc.terms[t].oper != EcsNot) {
+                p.field = static_cast<int8_t>(t);
+                break;
+            }
+        }
+        if (p.field < 0) {
+            throw std::runtime_error("where filter component must be a term of the query: " + std::string(py::str(spec[0])));
+        }
+        p.native = native_field(w, component, spec[1].cast<std::string>());
+        p.component_size = static_cast<size_t>(ecs_get_type_info(w, component)->size);
+        
+        static const std::map<std::string, PredicateOp> ops = {
+            {"<", PredLt}, {"<=", PredLe}, {">", PredGt}, {">=", PredGe}, {"==", PredEq}, {"!=", PredNe},
+            {"between", PredBetween}, {"in", PredIn}
+        };
+        std::string op_name = spec[2].cast<std::string>();
+        auto op = ops.find(op_name);
+        if (op == ops.end()) {
+            throw std::runtime_error("Unknown where operator: " + op_name);
+        }
+        p.op = op->second;
+        
+        ecs_entity_t type = p.native.type;
+        bool is_int64 = type == ecs_id(ecs_i64_t);
+        bool is_uint64 = type == ecs_id(ecs_u64_t) || type == ecs_id(ecs_entity_t);
+        if (p.op == PredIn && (type == ecs_id(ecs_f32_t) || type == ecs_id(ecs_f64_t))) {
+            throw std::runtime_error("where operator 'in' compares integers and can't be used on float field: " + p.native.name);
+        }
+        auto bound = [&](py::handle v, double& as_double, int64_t& as_int, uint64_t& as_uint) {
+            try {
+                if (is_int64) {
+                    as_int = v.cast<int64_t>();
+                } else if (is_uint64) {
+                    as_uint = py::isinstance<PyEntity>(v) ? v.cast<PyEntity>().entity.id() : v.cast<uint64_t>();
+                } else {
+                    as_double = v.cast<double>();
+                }
+            } catch (const py::cast_error&) {
+                throw std::runtime_error("where filter value doesn't fit the type of field " + p.native.name +
+                    ": " + std::string(py::str(v)));
+            }
+        };
+        
+        py::object value = spec[3];
+        if (p.op == PredBetween) {
+            py::tuple range = value.cast<py::tuple>();
+            bound(range[0], p.lo, p.int_lo, p.uint_lo);
+            bound(range[1], p.hi, p.int_hi, p.uint_hi);
+        } else if (p.op == PredIn) {
+            // Id sets (TagSet, View) or any iterable of integers
+            if (py::hasattr(value, "to_numpy")) {
+                value = value.attr("to_numpy")();
+            } else if (py::hasattr(value, "ids")) {
+                value = value.attr("ids")();
+            }
+            for (auto v : value) {
+                if (py::isinstance<PyEntity>(v)) {
+                    p.set.push_back(static_cast<int64_t>(v.cast<PyEntity>().entity.id()));
+                } else {
+                    p.set.push_back(is_uint64 ? static_cast<int64_t>(v.cast<uint64_t>()) : v.cast<int64_t>());
+                }
+            }
+            std::sort(p.set.begin(), p.set.end());
+        } else {
+            bound(value, p.lo, p.int_lo, p.uint_lo);
+        }
+        
+        // Rounded once, f32 fields are compared in float
+        if (type == ecs_id(ecs_f32_t)) {
+            switch (p.op) {
+            case PredLt:
+            case PredGe:
+                p.float_lo = float_bound(p.lo, true);
+                break;
+            case PredLe:
+            case PredGt:
+                p.float_lo = float_bound(p.lo, false);
+                break;
+            case PredEq:
+            case PredNe:
+                // A bound that isn't a float equals no field value
+                p.float_lo = float_bound(p.lo, true) == float_bound(p.lo, false) ?
+                    float_bound(p.lo, true) : std::numeric_limits<float>::quiet_NaN();
+                break;
+            case PredBetween:
+                p.float_lo = float_bound(p.lo, true);
+                p.float_hi = float_bound(p.hi, false);
+                break;
+            case PredIn:
+                break;
+            }
+        }
+        return p;
+    }
+    
+    // Every iterator of the query is created here: ecs_query_iter re-sorts the tables
+    // of an order_by query, and the comparator reads the field to sort on
+    ecs_iter_t query_iter() {
+        active_order_by_field = has_order_by ? &order_by_field : nullptr;
+        ecs_iter_t result = ecs_query_iter(world, query);
+        active_order_by_field = nullptr;
+        if (group_id) {
+            ecs_iter_set_group(&result, group_id);
+        }
+        return result;
+    }
+    
+    void begin() {
+        it = query_iter();
+    }
+    
+public:
+    PyQueryIterator(flecs::world& w, py::args args, bool changed_only = false,
+        py::object group_by = py::none(), py::object order_by = py::none(), bool memoize = false,
+        py::object where = py::none()) : world(w), changed_only(changed_only)
+    {
+        if (memoize && changed_only) {
+            throw std::runtime_error("A memoized query can't also be changed_only");
+        }
+        if (memoize && !where.is_none()) {
+            throw std::runtime_error("A memoized query can't have where filters, they depend on component values");
+        }
+        std::vector<std::string> var_names;
+        ecs_query_desc_t desc = generate_query_from_args(args, w, var_names, query_terms);
+        if (changed_only) {
+            enable_change_detection(desc);
+        }
+        
+        // Group tables by the target of a relationship, e.g. ("InCell", "*")
+        if (!group_by.is_none()) {
+            py::object relation = group_by;
+            if (py::isinstance<py::tuple>(group_by)) {
+                relation = group_by.cast<py::tuple>()[0];
+            }
+            desc.group_by = entity_from_object(w, relation);
+            desc.cache_kind = EcsQueryCacheAuto;
+        }
+        
+        // Sort by a native component field, e.g. ("Health", "hp")
+        if (!order_by.is_none()) {
+            py::tuple order_by_pair = order_by.cast<py::tuple>();
+            if (order_by_pair.size() != 2) {
+                throw std::runtime_error("order_by must be a (component, field) tuple");
+            }
+            py::object component_type = order_by_pair[0];
+            ecs_entity_t component = entity_from_object(w, component_type);
+            order_by_field = native_field(w, component, order_by_pair[1].cast<std::string>());
+            has_order_by = true;
+            
+            // The sorted component must be part of the query
+            size_t term_count = query_terms.size();
+            bool queried = false;
+            for (size_t t = 0; t < term_count && t < 32; t++) {
+                if (desc.terms[t].id == component || desc.terms[t].first.id == component) {
+                    queried = true;
+                }
+            }
+            if (!queried) {
+                if (term_count >= 32) {
+                    throw std::runtime_error("Too many query terms to add order_by component");
+                }
+                desc.terms[term_count].id = component;
+                desc.terms[term_count].inout = EcsIn;
+            }
+            
+            desc.order_by = component;
+            desc.order_by_callback = compare_native_field;
+            desc.cache_kind = EcsQueryCacheAuto;
+        }
+        
+        // Filters on native fields, e.g. [("Health", "hp", "<", 10), ("Team", "id", "in", [1, 2])]
+        if (!where.is_none()) {
+            for (auto item : where) {
+                predicates.push_back(parse_predicate(w, desc, py::reinterpret_borrow<py::object>(item)));
+            }
+        }
+        
+        query = ecs_query_init(w, &desc);
+        for (std::string var_name : var_names) {
             var_indices.push_back(ecs_query_find_var(query, var_name.c_str()));
             py::print(var_name);
         }
-        it = ecs_query_iter(world, query);
+        if (memoize) {
+            memo = std::make_shared<QueryMemo>();
+            watch_memo();
+        } else {
+            begin();
+        }
     }
 
     // Creation of PyQueryIterator for Observer
@@ -935,182 +2067,746 @@ public:
             var_indices.push_back(ecs_query_find_var(query, var_name.c_str()));
             py::print(var_name);
         }
-        it = ecs_query_iter(world, query);
+        begin();
     }
     
     PyQueryIterator& iter() {
+        // Memoized queries are meant to be iterated repeatedly
+        if (memo) {
+            memo_row = 0;
+        }
+        return *this;
+    }
+
+    // Restart iteration, optionally restricted to a single group
+    PyQueryIterator& iter_group(py::object group) {
+        // The memo holds the matches of all groups
+        if (memo && !group.is_none()) {
+            throw std::runtime_error("A memoized query can't be iterated by group");
+        }
+        group_id = group.is_none() ? 0 : entity_from_object(world, group);
+        reset();
         return *this;
     }
     
     py::list next() {
+        py::list value;
+        if (!next_row([&](py::object item) { value.append(std::move(item)); })) {
+            throw pybind11::stop_iteration();
+        }
+        return value;
+    }
+    
+    // Advance to the next result and pass its values to append. Returns false at the
+    // end, which lets native callers iterate without a list or an exception per result.
+    template <typename Append>
+    bool next_row(Append&& append) {
+        if (memo) {
+            if (!memo_valid()) {
+                evaluate_memo();
+                memo_row = 0;
+            }
+            if (memo_row >= memo->entities.size()) {
+                return false;
+            }
+            size_t row = memo_row++;
+            build_row(memo->entities[row],
+                memo->variables.data() + row * var_indices.size(),
+                memo->field_ids.data() + row * query_terms.size(), append);
+            return true;
+        }
+        
         bool result = true;
         if (next_archetype) {
             result = ecs_query_next(&it);
+            while (result && ((changed_only && !ecs_iter_changed(&it)) || !select_table_rows())) {
+                result = ecs_query_next(&it);
+            }
             next_archetype = false;
             i = 0;
-            current = it.count;
+            current = predicates.empty() ? it.count : selected.size();
         }
         
         if (result) {
-            ecs_entity_t source = it.entities[i];
-            py::list value;
+            ecs_entity_t source = it.entities[predicates.empty() ? i : selected[i]];
             
-            // Create a PyEntity from $this flecs entity as the first argument
-
-            int z = 0;
-            for (int var_index : var_indices)
-            {
-                if (var_index == 0)
-                {
-                    value.append(PyEntity(flecs::entity(world, source)));
-                } else
-                {
-                    PyEntity py_entity(flecs::entity(world, ecs_iter_get_var(&it, var_index)));
-                    value.append(py_entity);
-                    z++;
-                }
+            std::vector<ecs_entity_t> variables;
+            for (int var_index : var_indices) {
+                variables.push_back(var_index == 0 ? source : ecs_iter_get_var(&it, var_index));
             }
-            
-            // Process each query term
+            std::vector<ecs_id_t> field_ids;
             for (size_t term_idx = 0; term_idx < query_terms.size(); term_idx++) {
-                const QueryTerm& term = query_terms[term_idx];
-                
-                if (term.is_relationship) {
-                    if (term.is_wildcard_target || term.is_wildcard_relation) {
-                        // For wildcard relationships, we need to get the actual pair from the iterator
-                        ecs_id_t actual_id = ecs_field_id(&it, term_idx);
-                        
-                        if (ECS_IS_PAIR(actual_id)) {
-                            ecs_entity_t actual_relation = ecs_pair_first(world, actual_id);
-                            ecs_entity_t actual_target = ecs_pair_second(world, actual_id);
-                            
-                            if (term.is_wildcard_target) {
-                                // Return the actual target entity
-                                PyEntity target_entity(flecs::entity(world, actual_target));
-                                value.append(target_entity);
-                            }
-                            
-                            if (term.is_wildcard_relation) {
-                                // Return the actual relation entity
-                                PyEntity relation_entity(flecs::entity(world, actual_relation));
-                                value.append(relation_entity);
-                            }
-                            
-                            // Check if there's component data for this relationship
-                            if (flecs_component_pyobject[source].count(actual_id)) {
-                                value.append(flecs_component_pyobject[source][actual_id]);
-                            }
-                        }
-                    } else {
-                        // Specific relationship pair
-                        if (flecs_component_pyobject[source].count(term.id)) {
-                            value.append(flecs_component_pyobject[source][term.id]);
-                        }
-                    }
-                } else if (!term.is_tag) {
-                    // Regular component
-                    if (flecs_component_pyobject[source].count(term.id)) {
-                        value.append(flecs_component_pyobject[source][term.id]);
-                    }
-                }
-                // Tags don't add anything to the result tuple
+                field_ids.push_back(ecs_field_id(&it, static_cast<int8_t>(term_idx)));
             }
+            build_row(source, variables.data(), field_ids.data(), append);
             
             i++;
             if (i == current) {
                 next_archetype = true;
             }
-            return value;
+            return true;
+        }
+        return false;
+    }
+    
+    // Aggregations make one pass over a fresh iterator, so they don't disturb Python
+    // iteration. fn is called per result with the rows passing the where filters,
+    // or null for all rows.
+    template <typename Fn>
+    void scan(Fn&& fn) {
+        ecs_iter_t sit = query_iter();
+        std::vector<int32_t> rows;
+        while (ecs_query_next(&sit)) {
+            if (predicates.empty()) {
+                fn(sit, static_cast<const std::vector<int32_t>*>(nullptr));
+            } else {
+                select_rows(&sit, predicates, rows);
+                if (!rows.empty()) {
+                    fn(sit, &rows);
+                }
+            }
+        }
+    }
+    
+    // Groups are the value of a query variable ("$loc") or the target of a relationship
+    struct GroupBy {
+        int var = -1;
+        ecs_entity_t relation = 0;
+    };
+    
+    GroupBy group_by_spec(py::object by) {
+        GroupBy group;
+        if (py::isinstance<py::str>(by) && is_variable(by.cast<std::string>())) {
+            std::string name = by.cast<std::string>().substr(1);
+            group.var = ecs_query_find_var(query, name.c_str());
+            if (group.var <= 0) {
+                throw std::runtime_error("Query has no variable to group by: $" + name);
+            }
         } else {
-            throw pybind11::stop_iteration();
+            group.relation = entity_from_object(world, by);
+        }
+        return group;
+    }
+    
+    ecs_entity_t group_of(ecs_iter_t& sit, const GroupBy& group) {
+        if (group.var > 0) {
+            return ecs_iter_get_var(&sit, group.var);
+        }
+        ecs_id_t pair = 0;
+        if (!sit.table || ecs_search(world, sit.table, ecs_pair(group.relation, EcsWildcard), &pair) == -1) {
+            return 0;
+        }
+        return ecs_pair_second(world, pair);
+    }
+    
+    // Number of matched rows, without creating Python values for them
+    int64_t count() {
+        if (memo) {
+            if (!memo_valid()) {
+                evaluate_memo();
+            }
+            return static_cast<int64_t>(memo->entities.size());
+        }
+        int64_t total = 0;
+        scan([&](ecs_iter_t& sit, const std::vector<int32_t>* rows) {
+            total += rows ? static_cast<int64_t>(rows->size()) : sit.count;
+        });
+        return total;
+    }
+    
+    // (groups, counts) arrays, groups sorted by id. Rows without a group count under 0.
+    py::tuple group_count(py::object by) {
+        GroupBy group = group_by_spec(by);
+        std::map<ecs_entity_t, int64_t> counts;
+        scan([&](ecs_iter_t& sit, const std::vector<int32_t>* rows) {
+            counts[group_of(sit, group)] += rows ? static_cast<int64_t>(rows->size()) : sit.count;
+        });
+        
+        py::array_t<int64_t> keys(static_cast<py::ssize_t>(counts.size()));
+        py::array_t<int64_t> values(static_cast<py::ssize_t>(counts.size()));
+        int64_t* k = keys.mutable_data();
+        int64_t* v = values.mutable_data();
+        for (const auto& [key, count] : counts) {
+            *k++ = static_cast<int64_t>(key);
+            *v++ = count;
+        }
+        return py::make_tuple(keys, values);
+    }
+    
+    // sum, min, max or mean of a native field, as a float or as (groups, values) arrays
+    py::object aggregate(py::object component, const std::string& field_name, const std::string& op = "sum",
+        py::object by = py::none())
+    {
+        if (op != "sum" && op != "min" && op != "max" && op != "mean") {
+            throw std::runtime_error("Unknown aggregate: " + op);
+        }
+        ecs_entity_t component_id = entity_from_object(world, component);
+        int8_t field = -1;
+        for (int8_t t = 0; t < query->term_count; t++) {
+            if (query->terms[t].id == component_id && query->terms[t].oper != EcsNot) {
+                field = static_cast<int8_t>(query->terms[t].field_index);
+                break;
+            }
+        }
+        if (field < 0) {
+            throw std::runtime_error("Aggregated component must be a term of the query: " + std::string(py::str(component)));
+        }
+        NativeField native = native_field(world, component_id, field_name);
+        size_t size = static_cast<size_t>(ecs_get_type_info(world, component_id)->size);
+        
+        struct Accumulator {
+            double sum = 0.0;
+            double min = std::numeric_limits<double>::infinity();
+            double max = -std::numeric_limits<double>::infinity();
+            int64_t count = 0;
+            
+            double result(const std::string& op) const {
+                if (op == "sum") return sum;
+                if (!count) return std::numeric_limits<double>::quiet_NaN();
+                if (op == "min") return min;
+                if (op == "max") return max;
+                return sum / count;
+            }
+        };
+        
+        bool grouped = !by.is_none();
+        GroupBy group = grouped ? group_by_spec(by) : GroupBy();
+        std::map<ecs_entity_t, Accumulator> groups;
+        scan([&](ecs_iter_t& sit, const std::vector<int32_t>* rows) {
+            if (!ecs_field_is_set(&sit, field)) {
+                return;
+            }
+            Accumulator& acc = groups[grouped ? group_of(sit, group) : 0];
+            bool sparse = is_sparse_id(world, ecs_field_id(&sit, field));
+            const char* column = sparse ? nullptr : static_cast<const char*>(ecs_field_w_size(&sit, size, field));
+            size_t stride = ecs_field_is_self(&sit, field) ? size : 0;
+            int32_t count = rows ? static_cast<int32_t>(rows->size()) : sit.count;
+            for (int32_t r = 0; r < count; r++) {
+                int32_t row = rows ? (*rows)[r] : r;
+                const void* ptr = sparse ? ecs_field_at_w_size(&sit, size, field, row) : column + row * stride;
+                double value = native_field_get(native, ptr);
+                acc.sum += value;
+                acc.min = std::min(acc.min, value);
+                acc.max = std::max(acc.max, value);
+                acc.count++;
+            }
+        });
+        
+        if (!grouped) {
+            return py::float_(groups.empty() ? Accumulator().result(op) : groups[0].result(op));
         }
+        py::array_t<int64_t> keys(static_cast<py::ssize_t>(groups.size()));
+        py::array_t<double> values(static_cast<py::ssize_t>(groups.size()));
+        int64_t* k = keys.mutable_data();
+        double* v = values.mutable_data();
+        for (const auto& [key, acc] : groups) {
+            *k++ = static_cast<int64_t>(key);
+            *v++ = acc.result(op);
+        }
+        return py::make_tuple(keys, values);
+    }
+    
+    // Evaluate the where filters for the current table, false if no rows pass
+    bool select_table_rows() {
+        if (predicates.empty()) {
+            return true;
+        }
+        select_rows(&it, predicates, selected);
+        return !selected.empty();
     }
     
     void reset() {
-        it = ecs_query_iter(world, query);
+        if (memo) {
+            memo_row = 0;
+            return;
+        }
+        begin();
         i = 0;
         current = 0;
         next_archetype = true;
     }
 
+    ecs_world_t* world_ptr() const {
+        return world.c_ptr();
+    }
     
+    // Check if any table matched by the query changed since the last iteration
+    bool changed() {
+        if (!changed_only) {
+            throw std::runtime_error("Query must be created with changed_only=True to detect changes");
+        }
+        return ecs_query_changed(query);
+    }
+    
+    // Run a kernel over all matched rows on worker threads. Chunks are scheduled by
+    // work stealing, but partial results are reduced in chunk order so the result
+    // doesn't depend on which worker ran what. Kernels must not add or remove
+    // components or entities while they run, nor keep the field arrays they get.
+    py::object parallel_for(py::object kernel, int32_t threads = 0, int32_t chunk_size = 4096, bool select = false);
 };
 
 
-void PythonObserverCallback(ecs_iter_t *it) {
-    ecs_world_t *ecs = it->world;
-    ecs_entity_t event = it->event;
-    ecs_entity_t event_id = it->event_id;
+// Frame tracing. Spans are written to a ring buffer owned by the thread that
+// records them. The owning thread is the only writer and publishes each span by
+// advancing the ring's atomic head, a dump copies the ring and drops the slots
+// that were overwritten meanwhile. Buffers are registered under a global mutex
+// and returned to a free list when their thread exits. Each span is tagged with
+// its world, a dump only writes the spans of its own world. While no world is
+// tracing, a span costs one relaxed load.
+enum TraceKind : uint8_t {
+    TraceFrame,
+    TraceSystem,
+    TraceObserver,
+    TraceExportGraph
+};
+
+struct TraceEvent {
+    TraceKind kind;
+    const BindingState* state;
+    ecs_entity_t entity;
+    int64_t start;
+    int64_t duration;
+    // Time spent in Python callbacks, the rest of the span is native
+    int64_t python;
+};
+
+struct TraceRing {
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head{0};
     
-    // Find the Python callback associated with this observer
-    // For simplicity, we'll store the callback index in the observer's context
-    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    TraceRing(size_t capacity) : events(capacity) {}
+};
+
+struct TraceBuffer {
+    // Replaced by the owning thread when the trace capacity changes
+    std::atomic<TraceRing*> ring{nullptr};
+    // The ring it replaced, a dump may still be copying it. It is freed on the next
+    // replacement, which needs another capacity change and so can't overlap the dump.
+    std::unique_ptr<TraceRing> retired;
+    uint32_t thread_id = 0;
     
-    if (callback_index < observer_callbacks.size()) {
-        py::object callback = observer_callbacks[callback_index];
-        PyQueryIterator& py_query = observer_queries[callback_index];
-        
-        // Reset the query iterator to start fresh
-        py_query.reset();
-        
-        try {
-            // Iterate through the query results
-            while (true) {
-                py::list args = py_query.next();
-                callback(*args);
-            }
-        } catch (const pybind11::stop_iteration&) {
-            // Normal end of iteration
-        } catch (const std::exception& e) {
-            py::print("Error in observer callback:", e.what());
+    ~TraceBuffer() {
+        delete ring.load();
+    }
+};
+
+// Number of worlds that are tracing
+static std::atomic<int> trace_worlds{0};
+static std::atomic<size_t> trace_capacity{65536};
+static std::mutex trace_buffers_mutex;
+static std::vector<std::shared_ptr<TraceBuffer>> trace_buffers;
+// Buffers of threads that exited, reused by the next thread that records a span
+static std::vector<std::shared_ptr<TraceBuffer>> trace_free_buffers;
+
+int64_t trace_now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Hands the buffer of a thread back to the free list when the thread exits
+struct TraceBufferOwner {
+    std::shared_ptr<TraceBuffer> buffer;
+    
+    ~TraceBufferOwner() {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+            trace_free_buffers.push_back(std::move(buffer));
+        }
+    }
+};
+
+TraceBuffer& trace_buffer() {
+    thread_local TraceBufferOwner owner;
+    if (!owner.buffer) {
+        std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+        if (!trace_free_buffers.empty()) {
+            // Keeps the spans and thread id of the thread that exited
+            owner.buffer = std::move(trace_free_buffers.back());
+            trace_free_buffers.pop_back();
+        } else {
+            owner.buffer = std::make_shared<TraceBuffer>();
+            owner.buffer->thread_id = static_cast<uint32_t>(trace_buffers.size());
+            trace_buffers.push_back(owner.buffer);
         }
     }
+    return *owner.buffer;
 }
 
-void PythonSystemCallback(ecs_iter_t *it) {
-    ecs_world_t *ecs = it->world;
+void trace_record(const TraceEvent& event) {
+    TraceBuffer& buffer = trace_buffer();
+    // Only this thread replaces the ring
+    TraceRing* ring = buffer.ring.load(std::memory_order_relaxed);
+    size_t capacity = trace_capacity.load(std::memory_order_relaxed);
+    if (!ring || ring->events.size() != capacity) {
+        TraceRing* resized = new TraceRing(capacity);
+        buffer.retired.reset(ring);
+        buffer.ring.store(resized, std::memory_order_release);
+        ring = resized;
+    }
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head % ring->events.size()] = event;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Records a span from construction to destruction when tracing is enabled
+struct TraceSpan {
+    TraceKind kind;
+    ecs_entity_t entity;
+    const BindingState* state = nullptr;
+    bool active = false;
+    int64_t start = 0;
+    int64_t python = 0;
     
-    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    TraceSpan(TraceKind k, ecs_entity_t e, const ecs_world_t* world) : kind(k), entity(e) {
+        if (trace_worlds.load(std::memory_order_relaxed) > 0) {
+            state = &binding_state(world);
+            active = state->tracing.load(std::memory_order_relaxed);
+        }
+        if (active) {
+            start = trace_now();
+        }
+    }
     
-    if (callback_index < system_callbacks.size()) {
-        py::object callback = system_callbacks[callback_index];
-        
-        for (int i = 0; i < it->count; i++) {
-            ecs_entity_t entity_id = it->entities[i];
-            
-            // Create PyEntity wrapper
-            flecs::entity flecs_entity(ecs, entity_id);
-            PyEntity py_entity(flecs_entity);
-            
-            py::list args;
-            args.append(py_entity);
-            
-            for (int term_idx = 0; term_idx < it->field_count; term_idx++) {
-                ecs_entity_t comp_id = ecs_field_id(it, term_idx);
-                
-                if (flecs_component_pyobject[entity_id].count(comp_id)) {
-                    py::object& stored_component = flecs_component_pyobject[entity_id][comp_id];
-                    args.append(stored_component);
+    ~TraceSpan() {
+        if (active) {
+            trace_record({kind, state, entity, start, trace_now() - start, python});
+        }
+    }
+};
+
+// Adds the time of a Python call to the enclosing span
+struct TracePythonScope {
+    TraceSpan& span;
+    int64_t start;
+    
+    TracePythonScope(TraceSpan& s) : span(s), start(s.active ? trace_now() : 0) {}
+    
+    ~TracePythonScope() {
+        if (span.active) {
+            span.python += trace_now() - start;
+        }
+    }
+};
+
+// Asynchronous frames run ecs_progress on a native thread while the thread that
+// started them keeps running Python. Python callbacks of the frame are queued for
+// that owning thread, which runs them when it waits for the frame, when an asyncio
+// loop awaiting the frame gets to them, or when it calls Frame.poll().
+struct AsyncCallback {
+    ecs_iter_t* it;
+    ecs_iter_action_t callback;
+    bool done;
+};
+
+struct AsyncFrame {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<AsyncCallback*> pending;
+    bool done = false;
+    bool result = false;
+    // Accessed with the GIL held
+    py::object future;
+    py::object loop;
+    py::object pump;
+    
+    // Run the queued callbacks, called on the owning thread with the GIL held
+    void run_pending() {
+        while (true) {
+            AsyncCallback* cb;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (pending.empty()) {
+                    return;
                 }
+                cb = pending.front();
+                pending.pop_front();
             }
-            
             try {
-                // Call Python callback with entity and component references
-                callback(*args);
+                cb->callback(cb->it);
             } catch (const std::exception& e) {
-                py::print("Error in system callback:", e.what());
+                py::print("Error in asynchronous frame callback:", e.what());
             }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cb->done = true;
+            }
+            cv.notify_all();
         }
     }
-}
-
-void PythonObserverIterCallback(ecs_iter_t *it) {
-    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
     
-    if (callback_index < observer_iter_callbacks.size()) {
-        py::object callback = observer_iter_callbacks[callback_index];
-        
-        // Create PyIterator wrapper
+    // Run callbacks until the frame is done. Returns false on timeout (negative waits forever).
+    bool wait(double timeout) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(std::max(timeout, 0.0));
+        while (true) {
+            run_pending();
+            py::gil_scoped_release release;
+            std::unique_lock<std::mutex> lock(mutex);
+            auto ready = [this] { return done || !pending.empty(); };
+            if (timeout < 0) {
+                cv.wait(lock, ready);
+            } else if (!cv.wait_until(lock, deadline, ready)) {
+                return false;
+            }
+            if (done && pending.empty()) {
+                return true;
+            }
+        }
+    }
+};
+
+// Frame being run by the current thread. Frames in flight (asynchronous or run by
+// progress) are counted per world, and in total so that the world access check is
+// free while none are running.
+static thread_local AsyncFrame* current_async_frame = nullptr;
+static std::atomic<int> frames_in_any_world(0);
+// Depth of flecs callbacks on the current thread, which may use the world mid-frame
+static thread_local int frame_callback_depth = 0;
+
+struct FrameCallbackScope {
+    FrameCallbackScope() { frame_callback_depth++; }
+    ~FrameCallbackScope() { frame_callback_depth--; }
+};
+
+// Queue a callback of the current asynchronous frame for the owning thread and block
+// until it ran. Returns false if the current thread isn't running an asynchronous frame.
+bool run_on_owner(ecs_iter_t* it, ecs_iter_action_t callback) {
+    AsyncFrame* frame = current_async_frame;
+    if (!frame) {
+        return false;
+    }
+    
+    AsyncCallback cb = {it, callback, false};
+    {
+        std::lock_guard<std::mutex> lock(frame->mutex);
+        frame->pending.push_back(&cb);
+    }
+    frame->cv.notify_all();
+    {
+        py::gil_scoped_acquire gil;
+        if (frame->loop) {
+            try {
+                frame->loop.attr("call_soon_threadsafe")(frame->pump);
+            } catch (const py::error_already_set&) {
+                // The loop was closed, result() or poll() still run the callback
+            }
+        }
+    }
+    
+    std::unique_lock<std::mutex> lock(frame->mutex);
+    frame->cv.wait(lock, [&cb] { return cb.done; });
+    return true;
+}
+
+class PyFrame {
+public:
+    std::shared_ptr<AsyncFrame> frame;
+    
+    PyFrame(std::shared_ptr<AsyncFrame> f) : frame(f) {}
+    
+    bool done() {
+        std::lock_guard<std::mutex> lock(frame->mutex);
+        return frame->done;
+    }
+    
+    // Run callbacks the frame is waiting on, for event loops other than asyncio
+    bool poll() {
+        frame->run_pending();
+        return done();
+    }
+    
+    bool result(py::object timeout = py::none()) {
+        if (!frame->wait(timeout.is_none() ? -1.0 : timeout.cast<double>())) {
+            PyErr_SetString(PyExc_TimeoutError, "Frame did not finish in time");
+            throw py::error_already_set();
+        }
+        return frame->result;
+    }
+    
+    py::object await() {
+        py::module_ asyncio = py::module_::import("asyncio");
+        frame->loop = asyncio.attr("get_running_loop")();
+        // Callbacks queued before the loop was known
+        frame->loop.attr("call_soon")(frame->pump);
+        return asyncio.attr("wrap_future")(frame->future, py::arg("loop") = frame->loop).attr("__await__")();
+    }
+};
+
+// Calls a Python callable with an array of arguments through vectorcall, which skips
+// building an argument tuple. args[-1] must be writable when nargsf includes
+// PY_VECTORCALL_ARGUMENTS_OFFSET, which lets bound methods prepend self in place.
+inline void vectorcall(const py::object& callable, PyObject* const* args, size_t nargsf) {
+    PyObject* result = PyObject_Vectorcall(callable.ptr(), args, nargsf, nullptr);
+    if (!result) {
+        throw py::error_already_set();
+    }
+    Py_DECREF(result);
+}
+
+// True if only the caller holds a reference to obj. Free-threaded reference counts
+// are split between threads, so Py_REFCNT can't tell; interpreters without the
+// unstable API never reuse objects.
+inline bool is_uniquely_referenced(PyObject* obj) {
+#if defined(Py_GIL_DISABLED) && PY_VERSION_HEX >= 0x030E0000
+    return PyUnstable_Object_IsUniquelyReferenced(obj);
+#elif defined(Py_GIL_DISABLED)
+    (void)obj;
+    return false;
+#else
+    return Py_REFCNT(obj) == 1;
+#endif
+}
+
+void PythonObserverCallback(ecs_iter_t *it) {
+    // Python callbacks of an asynchronous frame run on the thread that started it
+    if (run_on_owner(it, PythonObserverCallback)) {
+        return;
+    }
+    ecs_world_t *ecs = it->world;
+    ecs_entity_t event = it->event;
+    ecs_entity_t event_id = it->event_id;
+    
+    // Find the Python callback associated with this observer
+    // For simplicity, we'll store the callback index in the observer's context
+    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    TraceSpan span(TraceObserver, it->system, it->world);
+    
+    // Observers and systems may run on flecs worker threads
+    FrameCallbackScope frame_scope;
+    py::gil_scoped_acquire gil;
+    BindingState& state = binding_state(it->world);
+    py::object callback;
+    if (registry_get(state, state.observer_callbacks, callback_index, callback)) {
+        PyQueryIterator* query_ptr;
+        {
+            BindingStateLock lock(state);
+            query_ptr = &state.observer_queries[callback_index];
+        }
+        PyQueryIterator& py_query = *query_ptr;
+        
+        // Reset the query iterator to start fresh
+        py_query.reset();
+        
+        try {
+            // Rows are collected in buffers reused for every result, slot 0 of the
+            // stack is scratch space for PY_VECTORCALL_ARGUMENTS_OFFSET. The payload
+            // of world.emit is passed after the row.
+            py::object payload = event_payload(it);
+            std::vector<py::object> row;
+            std::vector<PyObject*> stack(1, nullptr);
+            while (py_query.next_row([&](py::object item) { row.push_back(std::move(item)); })) {
+                if (!payload.is_none()) {
+                    row.push_back(payload);
+                }
+                stack.resize(row.size() + 1);
+                for (size_t a = 0; a < row.size(); a++) {
+                    stack[a + 1] = row[a].ptr();
+                }
+                {
+                    TracePythonScope python(span);
+                    vectorcall(callback, stack.data() + 1, row.size() | PY_VECTORCALL_ARGUMENTS_OFFSET);
+                }
+                row.clear();
+            }
+        } catch (const std::exception& e) {
+            py::print("Error in observer callback:", e.what());
+        }
+    }
+}
+
+void PythonSystemCallback(ecs_iter_t *it) {
+    if (run_on_owner(it, PythonSystemCallback)) {
+        return;
+    }
+    ecs_world_t *ecs = it->world;
+    
+    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    TraceSpan span(TraceSystem, it->system, it->world);
+    
+    FrameCallbackScope frame_scope;
+    py::gil_scoped_acquire gil;
+    BindingState& state = binding_state(it->world);
+    py::object callback;
+    if (registry_get(state, state.system_callbacks, callback_index, callback)) {
+        bool track_writes = false;
+        bool changed_only = false;
+        size_t arity = 1;
+        registry_get(state, state.system_track_writes, callback_index, track_writes);
+        registry_get(state, state.system_changed_only, callback_index, changed_only);
+        registry_get(state, state.system_arities, callback_index, arity);
+        
+        // Skip tables that haven't changed since the system last ran
+        if (changed_only && !ecs_iter_changed(it)) {
+            return;
+        }
+        
+        // The entity followed by one argument per field. Slot 0 is scratch space for
+        // PY_VECTORCALL_ARGUMENTS_OFFSET.
+        size_t field_count = std::min(arity - 1, static_cast<size_t>(it->field_count));
+        std::vector<PyObject*> stack(field_count + 2, nullptr);
+        std::vector<py::object> fields(field_count);
+        PyObject** args = stack.data() + 1;
+        
+        py::object entity_handle;
+        PyEntity* entity_ptr = nullptr;
+        
+        for (int i = 0; i < it->count; i++) {
+            ecs_entity_t entity_id = it->entities[i];
+            flecs::entity flecs_entity(ecs, entity_id);
+            
+            // Reuse the entity handle unless the previous call kept a reference to it
+            if (entity_handle && is_uniquely_referenced(entity_handle.ptr())) {
+                entity_ptr->entity = flecs_entity;
+            } else {
+                entity_handle = py::cast(PyEntity(flecs_entity));
+                entity_ptr = entity_handle.cast<PyEntity*>();
+            }
+            args[0] = entity_handle.ptr();
+            
+            for (size_t f = 0; f < field_count; f++) {
+                int8_t term_idx = static_cast<int8_t>(f);
+                ecs_entity_t comp_id = ecs_field_id(it, term_idx);
+                py::object& field = fields[f];
+                
+                // Optional fields that didn't match, e.g. the cascade parent of a root
+                if (!ecs_field_is_set(it, term_idx)) {
+                    field = py::none();
+                } else if (!ecs_field_is_self(it, term_idx)) {
+                    // Fields matched on another entity, e.g. the component of a cascade parent
+                    field = store_get(it->world, ecs_field_src(it, term_idx), comp_id);
+                } else {
+                    field = store_get(it->world, entity_id, comp_id);
+                    if (field && track_writes) {
+                        field = py::cast(PyTrackedComponent(ecs, entity_id, comp_id, field));
+                    }
+                }
+                args[f + 1] = field ? field.ptr() : Py_None;
+            }
+            
+            try {
+                // Call Python callback with entity and component references
+                TracePythonScope python(span);
+                vectorcall(callback, args, (field_count + 1) | PY_VECTORCALL_ARGUMENTS_OFFSET);
+            } catch (const std::exception& e) {
+                py::print("Error in system callback:", e.what());
+            }
+        }
+    }
+}
+
+void PythonObserverIterCallback(ecs_iter_t *it) {
+    if (run_on_owner(it, PythonObserverIterCallback)) {
+        return;
+    }
+    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    TraceSpan span(TraceObserver, it->system, it->world);
+    
+    FrameCallbackScope frame_scope;
+    py::gil_scoped_acquire gil;
+    BindingState& state = binding_state(it->world);
+    py::object callback;
+    if (registry_get(state, state.observer_iter_callbacks, callback_index, callback)) {
+        
+        // Create PyIterator wrapper
         flecs::world world(it->world);
         PyIterator py_iter(it, world);
         
@@ -1124,17 +2820,14 @@ void PythonObserverIterCallback(ecs_iter_t *it) {
             ecs_id_t field_id = ecs_field_id(it, field);
             
             for (int i = 0; i < it->count; i++) {
-                ecs_entity_t entity_id = it->entities[i];
-                if (flecs_component_pyobject[entity_id].count(field_id)) {
-                    field_components.append(flecs_component_pyobject[entity_id][field_id]);
-                } else {
-                    field_components.append(py::none());
-                }
+                py::object stored = store_get(it->world, it->entities[i], field_id);
+                field_components.append(stored ? stored : py::none());
             }
             args.append(field_components);
         }
         
         try {
+            TracePythonScope python(span);
             callback(*args);
         } catch (const std::exception& e) {
             py::print("Error in iterator observer callback:", e.what());
@@ -1142,12 +2835,68 @@ void PythonObserverIterCallback(ecs_iter_t *it) {
     }
 }
 
+// Entities collected for batch observers while world.emit is running, so that
+// each observer gets a single Python call per emit instead of one per table
+struct EmitBatch {
+    std::map<size_t, std::vector<ecs_entity_t>> entities;
+};
+static thread_local EmitBatch* active_emit_batch = nullptr;
+
+py::array_t<int64_t> entity_id_array(const ecs_entity_t* entities, size_t count) {
+    py::array_t<int64_t> result(static_cast<py::ssize_t>(count));
+    if (count) {
+        memcpy(result.mutable_data(), entities, count * sizeof(ecs_entity_t));
+    }
+    return result;
+}
+
+void PythonObserverBatchCallback(ecs_iter_t *it) {
+    if (run_on_owner(it, PythonObserverBatchCallback)) {
+        return;
+    }
+    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    
+    FrameCallbackScope frame_scope;
+    py::gil_scoped_acquire gil;
+    BindingState& state = binding_state(it->world);
+    py::object callback;
+    if (registry_get(state, state.observer_batch_callbacks, callback_index, callback)) {
+        if (active_emit_batch) {
+            std::vector<ecs_entity_t>& pending = active_emit_batch->entities[callback_index];
+            pending.insert(pending.end(), it->entities, it->entities + it->count);
+            return;
+        }
+        
+        // Events that don't come from world.emit (e.g. OnSet) are delivered per table
+        py::object payload = event_payload(it);
+        TraceSpan span(TraceObserver, it->system, it->world);
+        try {
+            TracePythonScope python(span);
+            callback(entity_id_array(it->entities, it->count), payload);
+        } catch (const std::exception& e) {
+            py::print("Error in batch observer callback:", e.what());
+        }
+    }
+}
+
 // Iterator-based system callback
 void PythonSystemIterCallback(ecs_iter_t *it) {
+    if (run_on_owner(it, PythonSystemIterCallback)) {
+        return;
+    }
     size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    TraceSpan span(TraceSystem, it->system, it->world);
     
-    if (callback_index < system_iter_callbacks.size()) {
-        py::object callback = system_iter_callbacks[callback_index];
+    FrameCallbackScope frame_scope;
+    py::gil_scoped_acquire gil;
+    BindingState& state = binding_state(it->world);
+    py::object callback;
+    if (registry_get(state, state.system_iter_callbacks, callback_index, callback)) {
+        bool changed_only = false;
+        registry_get(state, state.system_iter_changed_only, callback_index, changed_only);
+        if (changed_only && !ecs_iter_changed(it)) {
+            return;
+        }
         
         flecs::world world(it->world);
         PyIterator py_iter(it, world);
@@ -1159,19 +2908,21 @@ void PythonSystemIterCallback(ecs_iter_t *it) {
         for (int field = 0; field < it->field_count; field++) {
             py::list field_components;
             ecs_id_t field_id = ecs_field_id(it, field);
+            bool field_set = ecs_field_is_set(it, field);
+            
+            // Fields matched on another entity (e.g. a cascade parent) are shared by all rows
+            ecs_entity_t field_src = field_set && !ecs_field_is_self(it, field) ? ecs_field_src(it, field) : 0;
             
             for (int i = 0; i < it->count; i++) {
-                ecs_entity_t entity_id = it->entities[i];
-                if (flecs_component_pyobject[entity_id].count(field_id)) {
-                    field_components.append(flecs_component_pyobject[entity_id][field_id]);
-                } else {
-                    field_components.append(py::none());
-                }
+                ecs_entity_t entity_id = field_src ? field_src : it->entities[i];
+                py::object stored = field_set ? store_get(it->world, entity_id, field_id) : py::object();
+                field_components.append(stored ? stored : py::none());
             }
             args.append(field_components);
         }
         
         try {
+            TracePythonScope python(span);
             callback(*args);
         } catch (const std::exception& e) {
             py::print("Error in iterator system callback:", e.what());
@@ -1179,109 +2930,2406 @@ void PythonSystemIterCallback(ecs_iter_t *it) {
     }
 }
 
+// Batched systems gather an input component from every matched entity into
+// one array, call Python once per frame and scatter the result to an output
+struct SystemBatchSpec {
+    ecs_entity_t input = 0;
+    ecs_entity_t output = 0;
+    // Attribute of a Python component to gather from/scatter to, empty for the object itself
+    std::string input_field;
+    std::string output_field;
+    // Fields of native input/output components, empty for Python components
+    std::vector<NativeField> input_native;
+    std::vector<NativeField> output_native;
+    size_t input_size = 0;
+    size_t output_size = 0;
+    // Native input is gathered as float32 when all of its fields are f32, float64 otherwise
+    bool input_f32 = true;
+};
 
-// Simple wrapper for Flecs world
-class PyWorld {
-public:
-
-    void shutdown_flecs_module() {
-        flecs_component_pyobject.clear();
-        observer_callbacks.clear();
-        system_callbacks.clear();
-        observer_iter_callbacks.clear();
-        system_iter_callbacks.clear();
+// Drop the stored objects and callbacks. They are taken out under the lock and
+// released after unlocking, since their __del__ may use the world. Observer
+// queries are dropped too, they hold a reference to the world.
+void BindingState::clear() {
+    std::map<flecs::id_t, std::map<flecs::id_t, py::object>> objects;
+    std::deque<PyQueryIterator> queries;
+    std::vector<py::object> callbacks;
+    {
+        BindingStateLock lock(*this);
+        objects.swap(component_objects);
+        queries.swap(observer_queries);
+        for (std::vector<py::object>* registry : {&observer_callbacks, &system_callbacks, &observer_iter_callbacks,
+            &system_iter_callbacks, &observer_batch_callbacks, &system_batch_callbacks}) 
+        {
+            callbacks.insert(callbacks.end(), registry->begin(), registry->end());
+            registry->clear();
+        }
+        system_changed_only.clear();
+        system_track_writes.clear();
+        system_arities.clear();
+        system_iter_changed_only.clear();
+        system_batch_specs.clear();
     }
+}
 
-    flecs::world world;
+// Run callback for batched systems, iterates all matched tables in one call
+void PythonSystemBatchRun(ecs_iter_t *it) {
+    if (run_on_owner(it, PythonSystemBatchRun)) {
+        return;
+    }
+    size_t callback_index = reinterpret_cast<size_t>(it->ctx);
+    TraceSpan span(TraceSystem, it->system, it->world);
     
-    PyWorld() {
+    FrameCallbackScope frame_scope;
+    py::gil_scoped_acquire gil;
+    BindingState& state = binding_state(it->world);
+    py::object callback;
+    SystemBatchSpec spec;
+    if (!registry_get(state, state.system_batch_callbacks, callback_index, callback) ||
+        !registry_get(state, state.system_batch_specs, callback_index, spec))
+    {
+        while (ecs_iter_next(it)) {}
+        return;
     }
     
-    // Create entity
-    PyEntity entity() {
-        return PyEntity(world.entity());
+    std::vector<ecs_entity_t> entities;
+    std::vector<void*> output_rows;
+    std::vector<py::array> input_rows;
+    std::vector<double> native_input;
+    
+    // Gather pass: collect entities, input values and a pointer to the output of each entity
+    while (ecs_iter_next(it)) {
+        bool input_sparse = is_sparse_id(it->real_world, ecs_field_id(it, 0));
+        bool output_sparse = is_sparse_id(it->real_world, ecs_field_id(it, 1));
+        const void* input_column = spec.input_native.empty() || input_sparse ? nullptr : ecs_field_w_size(it, spec.input_size, 0);
+        void* output_column = output_sparse ? nullptr : ecs_field_w_size(it, spec.output_size, 1);
+        
+        for (int i = 0; i < it->count; i++) {
+            ecs_entity_t entity_id = it->entities[i];
+            entities.push_back(entity_id);
+            output_rows.push_back(output_sparse ? ecs_field_at_w_size(it, spec.output_size, 1, i) :
+                static_cast<char*>(output_column) + i * spec.output_size);
+            
+            if (!spec.input_native.empty()) {
+                const void* ptr = input_sparse ? ecs_field_at_w_size(it, spec.input_size, 0, i) :
+                    static_cast<const char*>(input_column) + i * spec.input_size;
+                for (const NativeField& field : spec.input_native) {
+                    native_input.push_back(native_field_get(field, ptr));
+                }
+                continue;
+            }
+            
+            py::object value = store_get(it->world, entity_id, spec.input);
+            if (value && !spec.input_field.empty()) {
+                value = value.attr(spec.input_field.c_str());
+            }
+            py::array row = py::array::ensure(value, py::array::c_style);
+            if (!row || row.dtype().kind() == 'O') {
+                PyErr_Clear();
+                py::print("Error in batch system: input of entity", entity_id, "is not a numeric array");
+                ecs_iter_fini(it);
+                return;
+            }
+            if (!input_rows.empty() && row.nbytes() != input_rows[0].nbytes()) {
+                py::print("Error in batch system: inputs must all have the same shape");
+                ecs_iter_fini(it);
+                return;
+            }
+            input_rows.push_back(row);
+        }
     }
-
-    PyEntity entity(const std::string& name) {
-        return PyEntity(world.entity(name.c_str()));
+    
+    if (entities.empty()) {
+        return;
     }
-
-    PyEntity entity(const std::string& name, const py::list& components_and_tags) {
-        PyEntity entity = PyEntity(world.entity(name.c_str()));
-
-        for (auto item : components_and_tags) {
-            try {
-                py::object item_obj = item.cast<py::object>();
-                
-                if (py::isinstance<py::str>(item_obj)) {
-                    // Handle string as tag
-                    std::string tag_name = py::str(item_obj);
-                    entity.add_tag(tag_name);
-                }
-                else if (py::isinstance<py::tuple>(item_obj)) {
-                    // Handle tuple as relationship
-                    py::tuple rel_tuple = item_obj.cast<py::tuple>();
-                    
-                    if (rel_tuple.size() == 2) {
-                        // Two-element tuple: (relation, target)
-                        py::object relation = rel_tuple[0];
-                        py::object target = rel_tuple[1];
-                        
-                        if (py::isinstance<py::str>(relation) && py::isinstance<py::str>(target)) {
-                            // Both strings
-                            entity.add_relationship(relation.cast<std::string>(), target.cast<std::string>());
-                        }
-                        else if (py::isinstance<py::str>(relation) && py::isinstance<PyEntity>(target)) {
-                            // String relation, PyEntity target
-                            PyEntity target_entity = target.cast<PyEntity>();
-                            entity.add_relationship(relation.cast<std::string>(), target_entity);
-                        }
-                        else if (py::isinstance<PyEntity>(relation) && py::isinstance<py::str>(target)) {
-                            // PyEntity relation, string target
-                            PyEntity relation_entity = relation.cast<PyEntity>();
-                            entity.add_relationship(relation_entity, target.cast<std::string>());
-                        }
-                        else if (py::isinstance<PyEntity>(relation) && py::isinstance<PyEntity>(target)) {
-                            // Both PyEntity
-                            PyEntity relation_entity = relation.cast<PyEntity>();
-                            PyEntity target_entity = target.cast<PyEntity>();
-                            entity.add_relationship(relation_entity, target_entity);
-                        }
-                        else if (py::isinstance<py::str>(relation)) {
-                            // String relation, component target
-                            entity.add_relationship(relation.cast<std::string>(), target);
-                        }
-                        else if (py::isinstance<py::str>(target)) {
-                            // Component relation, string target
-                            entity.add_relationship(relation, target.cast<std::string>());
-                        }
-                        else {
-                            // Component relation, component target
-                            entity.add_relationship(relation, target);
-                        }
-                    }
-                    else {
-                        py::print("Warning: Relationship tuple must have exactly 2 elements, got", rel_tuple.size());
-                    }
+    
+    py::ssize_t count = static_cast<py::ssize_t>(entities.size());
+    py::array batch;
+    if (!spec.input_native.empty()) {
+        py::ssize_t width = static_cast<py::ssize_t>(spec.input_native.size());
+        py::array_t<double> values(std::vector<py::ssize_t>{count, width}, native_input.data());
+        batch = spec.input_f32 ? py::array(values.attr("astype")("float32")) : values;
+    } else {
+        std::vector<py::ssize_t> shape = {count};
+        for (py::ssize_t d = 0; d < input_rows[0].ndim(); d++) {
+            shape.push_back(input_rows[0].shape(d));
+        }
+        batch = py::array(input_rows[0].dtype(), shape);
+        char* dst = static_cast<char*>(batch.mutable_data());
+        size_t row_bytes = static_cast<size_t>(input_rows[0].nbytes());
+        for (size_t i = 0; i < input_rows.size(); i++) {
+            memcpy(dst + i * row_bytes, input_rows[i].data(), row_bytes);
+        }
+    }
+    
+    py::object result;
+    try {
+        TracePythonScope python(span);
+        result = callback(batch);
+    } catch (const std::exception& e) {
+        py::print("Error in batch system callback:", e.what());
+        return;
+    }
+    if (result.is_none()) {
+        return;
+    }
+    
+    // Scatter pass: write one row of the result to each entity's output
+    try {
+        if (!spec.output_native.empty()) {
+            auto values = py::array_t<double, py::array::c_style | py::array::forcecast>::ensure(result);
+            size_t width = spec.output_native.size();
+            if (!values || static_cast<size_t>(values.size()) != entities.size() * width) {
+                throw std::runtime_error("result must have one row of " + std::to_string(width) + " values per entity");
+            }
+            const double* src = values.data();
+            for (void* ptr : output_rows) {
+                for (const NativeField& field : spec.output_native) {
+                    native_field_set_double(field, ptr, *src++);
                 }
-                else {
-                    // Handle as component instance
-                    entity.set_component_instance(item_obj);
+            }
+        } else {
+            for (size_t row = 0; row < entities.size(); row++) {
+                ecs_entity_t entity_id = entities[row];
+                py::object value = result[py::int_(row)];
+                if (spec.output_field.empty()) {
+                    store_set(it->world, entity_id, spec.output, value);
+                    static_cast<PyComponentRef*>(output_rows[row])->object = value.ptr();
+                } else if (py::object stored = store_get(it->world, entity_id, spec.output)) {
+                    stored.attr(spec.output_field.c_str()) = value;
                 }
-            } catch (const std::exception& e) {
-                py::print("Error processing component/tag/relationship:", e.what());
             }
         }
-        
-        return entity;
-    }
-
-    PyEntity component(const std::string& name) {
-        return PyEntity(world.component(name.c_str()));
+    } catch (const std::exception& e) {
+        py::print("Error scattering batch system result:", e.what());
+        return;
     }
-
-    PyEntity prefab(const std::string& name) {
-        return PyEntity(world.prefab(name.c_str()));
+    
+    // The output columns were written directly, flag them so change detection and
+    // OnSet observers see the result. Deferred while the system runs.
+    for (ecs_entity_t entity_id : entities) {
+        ecs_modified_id(it->world, entity_id, spec.output);
+    }
+}
+
+// Uniform grid over the fields of a native position component. Kept up to date
+// by an OnSet/OnRemove observer, so writes must go through set() or modified().
+// The observer can run on a worker thread while knn runs without the GIL, so
+// insert, remove and rebuild lock the index. Readers hold a shared lock on mutex.
+class SpatialIndex {
+public:
+    ecs_entity_t component;
+    std::vector<NativeField> fields;
+    size_t component_size;
+    float cell_size;
+    ecs_entity_t observer = 0;
+    mutable std::shared_mutex mutex;
+    
+    SpatialIndex(ecs_entity_t component, std::vector<NativeField> fields, size_t component_size, float cell_size)
+        : component(component), fields(fields), component_size(component_size), cell_size(cell_size) {}
+    
+    void insert(ecs_entity_t entity_id, const void* ptr) {
+        std::array<float, 3> pos = position(ptr);
+        CellKey key = cell_coords(pos);
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = entries.find(entity_id);
+        if (it != entries.end()) {
+            if (it->second.key == key) {
+                it->second.pos = pos;
+                return;
+            }
+            erase_from_cell(entity_id, it->second.key);
+        }
+        entries[entity_id] = {key, pos};
+        cells[key].push_back(entity_id);
+        extend_bounds(key);
+    }
+    
+    void remove(ecs_entity_t entity_id) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = entries.find(entity_id);
+        if (it != entries.end()) {
+            erase_from_cell(entity_id, it->second.key);
+            entries.erase(it);
+        }
+    }
+    
+    // Rebuild the index from all entities with the component. Cell keys are
+    // computed on worker threads, which dominates for large populations.
+    void rebuild(ecs_world_t* world, int threads) {
+        std::vector<ecs_entity_t> ids;
+        std::vector<std::array<float, 3>> positions;
+        
+        bool sparse = is_sparse_id(world, component);
+        ecs_iter_t it = ecs_each_id(world, component);
+        while (ecs_each_next(&it)) {
+            const char* column = sparse ? nullptr : static_cast<const char*>(ecs_field_w_size(&it, component_size, 0));
+            for (int i = 0; i < it.count; i++) {
+                ids.push_back(it.entities[i]);
+                positions.push_back(position(sparse ? static_cast<const char*>(ecs_field_at_w_size(&it, component_size, 0, i)) :
+                    column + i * component_size));
+            }
+        }
+        
+        std::vector<CellKey> keys(ids.size());
+        parallel_for(ids.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                keys[i] = cell_coords(positions[i]);
+            }
+        });
+        
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        cells.clear();
+        entries.clear();
+        entries.reserve(ids.size());
+        has_bounds = false;
+        for (size_t i = 0; i < ids.size(); i++) {
+            entries[ids[i]] = {keys[i], positions[i]};
+            cells[keys[i]].push_back(ids[i]);
+            extend_bounds(keys[i]);
+        }
+    }
+    
+    // Entities within radius of center, center and radius must be finite
+    std::vector<ecs_entity_t> within_radius(const std::array<float, 3>& center, float radius) const {
+        std::vector<ecs_entity_t> result;
+        if (!has_bounds) {
+            return result;
+        }
+        float radius_sq = radius * radius;
+        
+        // Only the part of the box that overlaps occupied cells
+        std::array<int64_t, 3> lo, hi;
+        double volume = 1;
+        for (size_t d = 0; d < 3; d++) {
+            lo[d] = std::max<int64_t>(min_cell[d], cell_index(static_cast<double>(center[d]) - radius));
+            hi[d] = std::min<int64_t>(max_cell[d], cell_index(static_cast<double>(center[d]) + radius));
+            if (lo[d] > hi[d]) {
+                return result;
+            }
+            volume *= static_cast<double>(hi[d] - lo[d] + 1);
+        }
+        
+        // A box with more cells than are occupied is mostly empty, scanning every
+        // entry is cheaper than probing it
+        if (volume > static_cast<double>(cells.size())) {
+            for (const auto& [entity_id, entry] : entries) {
+                if (distance_sq(entry.pos, center) <= radius_sq) {
+                    result.push_back(entity_id);
+                }
+            }
+            return result;
+        }
+        
+        for (int64_t x = lo[0]; x <= hi[0]; x++) {
+            for (int64_t y = lo[1]; y <= hi[1]; y++) {
+                for (int64_t z = lo[2]; z <= hi[2]; z++) {
+                    auto cell = cells.find(cell_key(x, y, z));
+                    if (cell == cells.end()) {
+                        continue;
+                    }
+                    for (ecs_entity_t entity_id : cell->second) {
+                        if (distance_sq(entries.at(entity_id).pos, center) <= radius_sq) {
+                            result.push_back(entity_id);
+                        }
+                    }
+                }
+            }
+        }
+        return result;
+    }
+    
+    // Find the k nearest entities by searching rings of cells around the point
+    // until no unvisited cell can contain a closer entity. Once the rings would
+    // probe more cells than are occupied, all entries are scanned instead.
+    std::vector<std::pair<float, ecs_entity_t>> knn(const std::array<float, 3>& point, size_t k) const {
+        std::vector<std::pair<float, ecs_entity_t>> heap;
+        if (k == 0 || entries.empty()) {
+            return heap;
+        }
+        auto consider = [&](ecs_entity_t entity_id, const std::array<float, 3>& pos) {
+            float d = distance_sq(pos, point);
+            if (heap.size() < k) {
+                heap.push_back({d, entity_id});
+                std::push_heap(heap.begin(), heap.end());
+            } else if (d < heap.front().first) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = {d, entity_id};
+                std::push_heap(heap.begin(), heap.end());
+            }
+        };
+        auto visit = [&](int64_t x, int64_t y, int64_t z) {
+            auto cell = cells.find(cell_key(x, y, z));
+            if (cell != cells.end()) {
+                for (ecs_entity_t entity_id : cell->second) {
+                    consider(entity_id, entries.at(entity_id).pos);
+                }
+            }
+        };
+        
+        // Rings before first_ring don't reach the occupied cells, last_ring covers them all
+        CellKey origin = cell_coords(point);
+        int64_t first_ring = 0, last_ring = 0;
+        for (size_t d = 0; d < 3; d++) {
+            int64_t o = origin[d];
+            first_ring = std::max({first_ring, min_cell[d] - o, o - max_cell[d]});
+            last_ring = std::max({last_ring, o - min_cell[d], max_cell[d] - o});
+        }
+        
+        double visited = 0;
+        for (int64_t ring = first_ring; ring <= last_ring; ring++) {
+            // The ring clamped to the occupied bounds, shell is its number of cells
+            std::array<int64_t, 3> lo, hi;
+            double outer = 1, inner = 1;
+            for (size_t d = 0; d < 3; d++) {
+                int64_t o = origin[d];
+                lo[d] = std::max<int64_t>(o - ring, min_cell[d]);
+                hi[d] = std::min<int64_t>(o + ring, max_cell[d]);
+                outer *= static_cast<double>(hi[d] - lo[d] + 1);
+                inner *= static_cast<double>(std::max<int64_t>(0, std::min(hi[d], o + ring - 1) - std::max(lo[d], o - ring + 1) + 1));
+            }
+            double shell = outer - inner;
+            if (visited + shell > static_cast<double>(cells.size())) {
+                heap.clear();
+                for (const auto& [entity_id, entry] : entries) {
+                    consider(entity_id, entry.pos);
+                }
+                break;
+            }
+            visited += shell;
+            
+            // Only visit the faces of the shell
+            int64_t z_lo = origin[2] - ring, z_hi = origin[2] + ring;
+            bool z_faces = (z_lo >= lo[2] && z_lo <= hi[2]) || (z_hi >= lo[2] && z_hi <= hi[2]);
+            for (int64_t x = lo[0]; x <= hi[0]; x++) {
+                bool x_face = x == origin[0] - ring || x == origin[0] + ring;
+                for (int64_t y = lo[1]; y <= hi[1]; y++) {
+                    if (x_face || y == origin[1] - ring || y == origin[1] + ring) {
+                        for (int64_t z = lo[2]; z <= hi[2]; z++) {
+                            visit(x, y, z);
+                        }
+                        continue;
+                    }
+                    if (!z_faces) {
+                        // Nothing between the y faces, jump to the far one
+                        if (y < origin[1] + ring - 1) {
+                            y = origin[1] + ring - 1;
+                        }
+                        continue;
+                    }
+                    if (z_lo >= lo[2]) {
+                        visit(x, y, z_lo);
+                    }
+                    if (z_hi <= hi[2] && z_hi != z_lo) {
+                        visit(x, y, z_hi);
+                    }
+                }
+            }
+            
+            // Cells outside this ring are at least ring * cell_size away
+            float reach = static_cast<float>(ring) * cell_size;
+            if (heap.size() == k && heap.front().first <= reach * reach) {
+                break;
+            }
+        }
+        
+        std::sort_heap(heap.begin(), heap.end());
+        return heap;
+    }
+    
+    static bool is_finite(const std::array<float, 3>& point) {
+        return std::isfinite(point[0]) && std::isfinite(point[1]) && std::isfinite(point[2]);
+    }
+    
+    size_t size() const {
+        return entries.size();
+    }
+    
+    std::array<float, 3> point_from(py::handle obj) const {
+        std::array<float, 3> point = {0, 0, 0};
+        py::sequence seq = py::reinterpret_borrow<py::sequence>(obj);
+        for (size_t d = 0; d < fields.size() && d < seq.size(); d++) {
+            point[d] = seq[d].cast<float>();
+        }
+        return point;
+    }
+    
+    template <typename Fn>
+    static void parallel_for(size_t count, int threads, Fn&& fn) {
+        if (threads <= 0) {
+            threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+        // Not worth spawning threads for small inputs
+        size_t chunk = std::max<size_t>(4096, (count + threads - 1) / threads);
+        if (count <= chunk) {
+            fn(0, count);
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            workers.emplace_back(fn, begin, std::min(count, begin + chunk));
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+    
+private:
+    typedef std::array<int32_t, 3> CellKey;
+    
+    // Mixes all bits of the three coordinates, cells far apart never share a key
+    struct CellHash {
+        size_t operator()(const CellKey& c) const {
+            uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(c[0])) << 32) | static_cast<uint32_t>(c[1]);
+            h ^= static_cast<uint64_t>(static_cast<uint32_t>(c[2])) * 0x9E3779B97F4A7C15ull;
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return static_cast<size_t>(h);
+        }
+    };
+    
+    struct Entry {
+        CellKey key;
+        std::array<float, 3> pos;
+    };
+    
+    std::unordered_map<CellKey, std::vector<ecs_entity_t>, CellHash> cells;
+    std::unordered_map<ecs_entity_t, Entry> entries;
+    // Bounds of the occupied cells, limits the knn and radius searches
+    bool has_bounds = false;
+    std::array<int64_t, 3> min_cell = {0, 0, 0};
+    std::array<int64_t, 3> max_cell = {0, 0, 0};
+    
+    void extend_bounds(const CellKey& c) {
+        for (size_t d = 0; d < 3; d++) {
+            min_cell[d] = has_bounds ? std::min<int64_t>(min_cell[d], c[d]) : c[d];
+            max_cell[d] = has_bounds ? std::max<int64_t>(max_cell[d], c[d]) : c[d];
+        }
+        has_bounds = true;
+    }
+    
+    std::array<float, 3> position(const void* ptr) const {
+        std::array<float, 3> pos = {0, 0, 0};
+        for (size_t d = 0; d < fields.size(); d++) {
+            pos[d] = static_cast<float>(native_field_get(fields[d], ptr));
+        }
+        return pos;
+    }
+    
+    CellKey cell_coords(const std::array<float, 3>& pos) const {
+        return {cell_index(pos[0]), cell_index(pos[1]), cell_index(pos[2])};
+    }
+    
+    // Clamped to the range of a cell key, NaN lands in cell 0
+    int32_t cell_index(double value) const {
+        double c = std::floor(value / cell_size);
+        if (std::isnan(c)) {
+            return 0;
+        }
+        return static_cast<int32_t>(std::clamp<double>(c, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
+    }
+    
+    static CellKey cell_key(int64_t x, int64_t y, int64_t z) {
+        return {static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(z)};
+    }
+    
+    static float distance_sq(const std::array<float, 3>& a, const std::array<float, 3>& b) {
+        float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+    
+    void erase_from_cell(ecs_entity_t entity_id, const CellKey& key) {
+        auto cell = cells.find(key);
+        if (cell == cells.end()) {
+            return;
+        }
+        std::vector<ecs_entity_t>& ids = cell->second;
+        auto pos = std::find(ids.begin(), ids.end(), entity_id);
+        if (pos != ids.end()) {
+            *pos = ids.back();
+            ids.pop_back();
+        }
+        if (ids.empty()) {
+            cells.erase(cell);
+            // Shrink the bounds when the cell was on their edge
+            for (size_t d = 0; d < 3; d++) {
+                if (key[d] == min_cell[d] || key[d] == max_cell[d]) {
+                    recompute_bounds();
+                    break;
+                }
+            }
+        }
+    }
+    
+    void recompute_bounds() {
+        has_bounds = false;
+        for (const auto& [key, ids] : cells) {
+            extend_bounds(key);
+        }
+    }
+};
+
+void SpatialIndexObserver(ecs_iter_t *it) {
+    SpatialIndex* index = static_cast<SpatialIndex*>(it->ctx);
+    if (it->event == EcsOnRemove) {
+        for (int i = 0; i < it->count; i++) {
+            index->remove(it->entities[i]);
+        }
+        return;
+    }
+    
+    bool sparse = is_sparse_id(it->real_world, ecs_field_id(it, 0));
+    const char* column = sparse ? nullptr : static_cast<const char*>(ecs_field_w_size(it, index->component_size, 0));
+    for (int i = 0; i < it->count; i++) {
+        index->insert(it->entities[i], sparse ? static_cast<const char*>(ecs_field_at_w_size(it, index->component_size, 0, i)) :
+            column + i * index->component_size);
+    }
+}
+
+// Bitmap of entity indices (the id without its generation), split into chunks of
+// 65536 bits that are only allocated when they contain an entity. Set operations
+// work on whole 64 bit words in loops the compiler can vectorize.
+inline uint32_t popcount64(uint64_t word) {
+#if defined(_MSC_VER)
+    return static_cast<uint32_t>(__popcnt64(word));
+#else
+    return static_cast<uint32_t>(__builtin_popcountll(word));
+#endif
+}
+
+class TagBitmap {
+public:
+    static const size_t CHUNK_WORDS = 1024;
+    
+    struct Chunk {
+        std::array<uint64_t, CHUNK_WORDS> words = {};
+        uint32_t count = 0;
+    };
+    
+    std::map<uint32_t, std::unique_ptr<Chunk>> chunks;
+    
+    TagBitmap() = default;
+    
+    TagBitmap(const TagBitmap& other) {
+        for (const auto& [key, chunk] : other.chunks) {
+            chunks[key] = std::make_unique<Chunk>(*chunk);
+        }
+    }
+    
+    void insert(ecs_entity_t e) {
+        uint32_t index = static_cast<uint32_t>(e);
+        std::unique_ptr<Chunk>& chunk = chunks[index >> 16];
+        if (!chunk) {
+            chunk = std::make_unique<Chunk>();
+        }
+        uint64_t& word = chunk->words[(index & 0xFFFF) >> 6];
+        uint64_t bit = uint64_t(1) << (index & 63);
+        chunk->count += (word & bit) ? 0 : 1;
+        word |= bit;
+    }
+    
+    void remove(ecs_entity_t e) {
+        uint32_t index = static_cast<uint32_t>(e);
+        auto found = chunks.find(index >> 16);
+        if (found == chunks.end()) {
+            return;
+        }
+        uint64_t& word = found->second->words[(index & 0xFFFF) >> 6];
+        uint64_t bit = uint64_t(1) << (index & 63);
+        if (word & bit) {
+            word &= ~bit;
+            if (--found->second->count == 0) {
+                chunks.erase(found);
+            }
+        }
+    }
+    
+    bool contains(ecs_entity_t e) const {
+        uint32_t index = static_cast<uint32_t>(e);
+        auto found = chunks.find(index >> 16);
+        return found != chunks.end() && (found->second->words[(index & 0xFFFF) >> 6] >> (index & 63)) & 1;
+    }
+    
+    size_t count() const {
+        size_t total = 0;
+        for (const auto& [key, chunk] : chunks) {
+            total += chunk->count;
+        }
+        return total;
+    }
+    
+    // Combine two bitmaps word by word, keep_unmatched_a/b control chunks that only one side has
+    template <typename Op>
+    static TagBitmap combine(const TagBitmap& a, const TagBitmap& b, Op op, bool keep_only_a, bool keep_only_b) {
+        TagBitmap result;
+        auto ia = a.chunks.begin();
+        auto ib = b.chunks.begin();
+        while (ia != a.chunks.end() || ib != b.chunks.end()) {
+            if (ib == b.chunks.end() || (ia != a.chunks.end() && ia->first < ib->first)) {
+                if (keep_only_a) {
+                    result.chunks[ia->first] = std::make_unique<Chunk>(*ia->second);
+                }
+                ++ia;
+            } else if (ia == a.chunks.end() || ib->first < ia->first) {
+                if (keep_only_b) {
+                    result.chunks[ib->first] = std::make_unique<Chunk>(*ib->second);
+                }
+                ++ib;
+            } else {
+                std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>();
+                const uint64_t* wa = ia->second->words.data();
+                const uint64_t* wb = ib->second->words.data();
+                uint64_t* out = chunk->words.data();
+                for (size_t w = 0; w < CHUNK_WORDS; w++) {
+                    out[w] = op(wa[w], wb[w]);
+                }
+                for (size_t w = 0; w < CHUNK_WORDS; w++) {
+                    chunk->count += popcount64(out[w]);
+                }
+                if (chunk->count) {
+                    result.chunks[ia->first] = std::move(chunk);
+                }
+                ++ia;
+                ++ib;
+            }
+        }
+        return result;
+    }
+    
+    // Entity indices in ascending order
+    std::vector<uint32_t> indices() const {
+        std::vector<uint32_t> result;
+        result.reserve(count());
+        for (const auto& [key, chunk] : chunks) {
+            for (size_t w = 0; w < CHUNK_WORDS; w++) {
+                uint64_t word = chunk->words[w];
+                while (word) {
+                    // Position of the lowest set bit
+                    uint32_t bit = popcount64((word & (~word + 1)) - 1);
+                    result.push_back((key << 16) | static_cast<uint32_t>(w << 6) | bit);
+                    word &= word - 1;
+                }
+            }
+        }
+        return result;
+    }
+};
+
+void TagBitmapObserver(ecs_iter_t *it) {
+    TagBitmap* bitmap = static_cast<TagBitmap*>(it->ctx);
+    for (int i = 0; i < it->count; i++) {
+        if (it->event == EcsOnAdd) {
+            bitmap->insert(it->entities[i]);
+        } else {
+            bitmap->remove(it->entities[i]);
+        }
+    }
+}
+
+// Python handle to a tag bitmap. Sets returned by world.tag_set are kept up to date
+// by observers, sets produced by operators are snapshots. The set holds the binding
+// state of its world, so it can tell when the world is gone.
+class PyTagSet {
+public:
+    std::shared_ptr<BindingState> state;
+    ecs_world_t* world;
+    std::shared_ptr<TagBitmap> bitmap;
+    
+    PyTagSet(std::shared_ptr<BindingState> s, ecs_world_t* w, std::shared_ptr<TagBitmap> b) : state(s), world(w), bitmap(b) {}
+    
+    PyTagSet and_(const PyTagSet& other) const {
+        same_world(other);
+        return PyTagSet(state, world, std::make_shared<TagBitmap>(TagBitmap::combine(*bitmap, *other.bitmap,
+            [](uint64_t a, uint64_t b) { return a & b; }, false, false)));
+    }
+    
+    PyTagSet or_(const PyTagSet& other) const {
+        same_world(other);
+        return PyTagSet(state, world, std::make_shared<TagBitmap>(TagBitmap::combine(*bitmap, *other.bitmap,
+            [](uint64_t a, uint64_t b) { return a | b; }, true, true)));
+    }
+    
+    PyTagSet andnot(const PyTagSet& other) const {
+        same_world(other);
+        return PyTagSet(state, world, std::make_shared<TagBitmap>(TagBitmap::combine(*bitmap, *other.bitmap,
+            [](uint64_t a, uint64_t b) { return a & ~b; }, true, false)));
+    }
+    
+    size_t count() const {
+        return bitmap->count();
+    }
+    
+    // The bitmap only stores entity indices, so the generation is checked against the world
+    bool contains(py::handle e) const {
+        ecs_entity_t id = py::isinstance<PyEntity>(e) ? e.cast<PyEntity>().entity.id() : e.cast<ecs_entity_t>();
+        return id && bitmap->contains(id) && ecs_is_alive(live_world(), id);
+    }
+    
+    // Ids of the entities in the set, with their current generation
+    py::array_t<int64_t> to_numpy() const {
+        ecs_world_t* w = live_world();
+        std::vector<uint32_t> indices = bitmap->indices();
+        py::array_t<int64_t> result(static_cast<py::ssize_t>(indices.size()));
+        int64_t* out = result.mutable_data();
+        for (size_t i = 0; i < indices.size(); i++) {
+            out[i] = static_cast<int64_t>(ecs_get_alive(w, indices[i]));
+        }
+        return result;
+    }
+    
+private:
+    ecs_world_t* live_world() const {
+        if (!state->alive) {
+            throw std::runtime_error("The world of this tag set was destroyed");
+        }
+        return world;
+    }
+    
+    // Entity indices of different worlds don't refer to the same entities
+    void same_world(const PyTagSet& other) const {
+        if (other.state != state) {
+            throw std::runtime_error("Tag sets of different worlds can't be combined");
+        }
+    }
+};
+
+// Entities matching a query, maintained by a monitor observer instead of by
+// re-running the query. Ids are dense (removal swaps in the last id) and every
+// membership change is logged so readers can catch up from an earlier version.
+struct QueryView {
+    struct Change {
+        uint64_t version;
+        ecs_entity_t entity;
+        bool added;
+    };
+    
+    std::vector<ecs_entity_t> ids;
+    std::unordered_map<ecs_entity_t, size_t> slots;
+    uint64_t version = 0;
+    std::deque<Change> log;
+    // Changes up to and including this version were dropped from the log
+    uint64_t log_floor = 0;
+    
+    void insert(ecs_entity_t e) {
+        if (slots.emplace(e, ids.size()).second) {
+            ids.push_back(e);
+            record(e, true);
+        }
+    }
+    
+    void remove(ecs_entity_t e) {
+        auto it = slots.find(e);
+        if (it == slots.end()) {
+            return;
+        }
+        size_t slot = it->second;
+        slots.erase(it);
+        ecs_entity_t last = ids.back();
+        ids.pop_back();
+        if (last != e) {
+            ids[slot] = last;
+            slots[last] = slot;
+        }
+        record(e, false);
+    }
+    
+    // The log is kept at a size proportional to the view so it can't grow without bound
+    void record(ecs_entity_t e, bool added) {
+        log.push_back({++version, e, added});
+        size_t limit = std::max<size_t>(1024, 2 * ids.size());
+        while (log.size() > limit) {
+            log_floor = log.front().version;
+            log.pop_front();
+        }
+    }
+};
+
+void QueryViewObserver(ecs_iter_t *it) {
+    QueryView* view = static_cast<std::shared_ptr<QueryView>*>(it->ctx)->get();
+    for (int i = 0; i < it->count; i++) {
+        if (it->event == EcsOnAdd) {
+            view->insert(it->entities[i]);
+        } else {
+            view->remove(it->entities[i]);
+        }
+    }
+}
+
+class PyView {
+public:
+    std::shared_ptr<QueryView> view;
+    // The monitor observer is deleted when the last copy of the view is dropped
+    std::shared_ptr<ObserverHandle> observer;
+    
+    PyView(std::shared_ptr<QueryView> v, std::shared_ptr<ObserverHandle> o) : view(v), observer(o) {}
+    
+    // Copy of the matching ids. The storage is reallocated as the view grows, so
+    // an array over it could dangle.
+    py::array_t<int64_t> ids() const {
+        return entity_id_array(view->ids.data(), view->ids.size());
+    }
+    
+    uint64_t version() const {
+        return view->version;
+    }
+    
+    size_t count() const {
+        return view->ids.size();
+    }
+    
+    bool contains(py::handle e) const {
+        ecs_entity_t id = py::isinstance<PyEntity>(e) ? e.cast<PyEntity>().entity.id() : e.cast<ecs_entity_t>();
+        return view->slots.count(id) != 0;
+    }
+    
+    // Entities that joined and left the view since a version returned by version()
+    py::tuple delta(uint64_t since) const {
+        if (since < view->log_floor) {
+            throw std::runtime_error("Changes since version " + std::to_string(since) +
+                " are no longer available, read ids() instead");
+        }
+        
+        // Compare membership at the start and end of the range, so an entity that
+        // was added and removed again shows up in neither list
+        std::vector<ecs_entity_t> order;
+        std::unordered_map<ecs_entity_t, std::pair<bool, bool>> membership;
+        auto first = std::upper_bound(view->log.begin(), view->log.end(), since,
+            [](uint64_t v, const QueryView::Change& c) { return v < c.version; });
+        for (auto it = first; it != view->log.end(); ++it) {
+            auto inserted = membership.emplace(it->entity, std::make_pair(!it->added, it->added));
+            if (inserted.second) {
+                order.push_back(it->entity);
+            } else {
+                inserted.first->second.second = it->added;
+            }
+        }
+        
+        std::vector<ecs_entity_t> added, removed;
+        for (ecs_entity_t e : order) {
+            const std::pair<bool, bool>& m = membership[e];
+            if (!m.first && m.second) {
+                added.push_back(e);
+            } else if (m.first && !m.second) {
+                removed.push_back(e);
+            }
+        }
+        return py::make_tuple(entity_id_array(added.data(), added.size()),
+            entity_id_array(removed.data(), removed.size()));
+    }
+};
+
+// World images are a sequential binary format in which bulk data (entity ids,
+// native columns and pickle buffers) starts on a page boundary, so a mapped
+// image can be handed to flecs and numpy without reformatting.
+static const char WORLD_IMAGE_MAGIC[8] = {'F', 'L', 'E', 'C', 'S', 'I', 'M', 'G'};
+static const uint32_t WORLD_IMAGE_VERSION = 2;
+static const size_t WORLD_IMAGE_PAGE_SIZE = 4096;
+
+class ImageWriter {
+public:
+    ImageWriter(const std::string& path) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Failed to open image for writing: " + path);
+        }
+    }
+    
+    ~ImageWriter() {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+    
+    void write(const void* data, size_t size) {
+        if (size && std::fwrite(data, 1, size, file) != size) {
+            throw std::runtime_error("Failed to write world image");
+        }
+        pos += size;
+    }
+    
+    template <typename T>
+    void value(T v) {
+        write(&v, sizeof(T));
+    }
+    
+    void string(const std::string& str) {
+        value<uint32_t>(static_cast<uint32_t>(str.size()));
+        write(str.data(), str.size());
+    }
+    
+    // Write a bulk block starting at the next page boundary
+    void block(const void* data, size_t size) {
+        static const char zeros[WORLD_IMAGE_PAGE_SIZE] = {};
+        write(zeros, (WORLD_IMAGE_PAGE_SIZE - pos % WORLD_IMAGE_PAGE_SIZE) % WORLD_IMAGE_PAGE_SIZE);
+        write(data, size);
+    }
+    
+private:
+    std::FILE* file = nullptr;
+    size_t pos = 0;
+};
+
+class ImageReader {
+public:
+    ImageReader(const char* data, size_t size) : data(data), size(size) {}
+    
+    const char* read(size_t n) {
+        if (pos + n > size) {
+            throw std::runtime_error("World image is truncated");
+        }
+        const char* ptr = data + pos;
+        pos += n;
+        return ptr;
+    }
+    
+    template <typename T>
+    T value() {
+        T v;
+        memcpy(&v, read(sizeof(T)), sizeof(T));
+        return v;
+    }
+    
+    std::string string() {
+        uint32_t len = value<uint32_t>();
+        return std::string(read(len), len);
+    }
+    
+    size_t remaining() const {
+        return size - pos;
+    }
+    
+    // Returns the offset of a page aligned block into the image
+    size_t block(size_t n) {
+        pos += (WORLD_IMAGE_PAGE_SIZE - pos % WORLD_IMAGE_PAGE_SIZE) % WORLD_IMAGE_PAGE_SIZE;
+        size_t offset = pos;
+        read(n);
+        return offset;
+    }
+    
+private:
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+};
+
+// Check if an entity is part of the flecs module (same id in every world)
+bool is_builtin_entity(ecs_world_t* world, ecs_entity_t entity) {
+    for (ecs_entity_t cur = entity; cur; cur = ecs_get_parent(world, cur)) {
+        if (cur == EcsFlecs) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Storage traits change how an id is stored and have to be added before it is
+// used. Images, journals and deltas write them with each definition as a mask.
+std::array<ecs_entity_t, 4> storage_traits() {
+    return {EcsSparse, EcsDontFragment, EcsCanToggle, EcsUnion};
+}
+
+uint8_t storage_trait_mask(ecs_world_t* world, ecs_entity_t e) {
+    uint8_t mask = 0;
+    if (!ecs_is_alive(world, e)) {
+        return mask;
+    }
+    std::array<ecs_entity_t, 4> traits = storage_traits();
+    for (size_t t = 0; t < traits.size(); t++) {
+        if (ecs_has_id(world, e, traits[t])) {
+            mask |= static_cast<uint8_t>(1 << t);
+        }
+    }
+    return mask;
+}
+
+void add_storage_traits(ecs_world_t* world, ecs_entity_t e, uint8_t mask) {
+    std::array<ecs_entity_t, 4> traits = storage_traits();
+    for (size_t t = 0; t < traits.size(); t++) {
+        if (!(mask & (1 << t)) || ecs_has_id(world, e, traits[t])) {
+            continue;
+        }
+        if (ecs_id_in_use(world, e) || ecs_id_in_use(world, ecs_pair(e, EcsWildcard))) {
+            throw std::runtime_error("Can't add storage trait " + std::string(ecs_get_name(world, traits[t])) +
+                " to " + std::string(flecs::entity(world, e).path().c_str()) + ", it is already in use");
+        }
+        ecs_add_id(world, e, traits[t]);
+    }
+}
+
+bool is_storage_trait(ecs_id_t id) {
+    std::array<ecs_entity_t, 4> traits = storage_traits();
+    return std::find(traits.begin(), traits.end(), id) != traits.end();
+}
+
+// Components, tags and relationships with the DontFragment trait. Their ids aren't
+// part of table types, so code that walks tables looks them up per entity.
+std::vector<ecs_entity_t> non_fragmenting_ids(ecs_world_t* world) {
+    std::vector<ecs_entity_t> ids;
+    ecs_iter_t it = ecs_each_id(world, EcsDontFragment);
+    while (ecs_each_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            if (!is_builtin_entity(world, it.entities[i])) {
+                ids.push_back(it.entities[i]);
+            }
+        }
+    }
+    return ids;
+}
+
+// Appends the non-fragmenting ids of an entity, with a pair for each target of a
+// non-fragmenting relationship
+void append_non_fragmenting(ecs_world_t* world, ecs_entity_t e, const std::vector<ecs_entity_t>& ids,
+    std::vector<ecs_id_t>& out)
+{
+    for (ecs_entity_t id : ids) {
+        if (ecs_has_id(world, e, id)) {
+            out.push_back(id);
+        }
+        ecs_entity_t target;
+        for (int32_t index = 0; (target = ecs_get_target(world, e, id, index)); index++) {
+            out.push_back(ecs_pair(id, target));
+        }
+    }
+}
+
+// Appends the ids of a table that are disabled for one of its entities. The table
+// type only has a toggle entry for each CanToggle id, not the enable bits.
+void append_disabled_toggles(ecs_world_t* world, ecs_table_t* table, ecs_entity_t e, std::vector<ecs_id_t>& out) {
+    const ecs_type_t* type = ecs_table_get_type(table);
+    for (int32_t t = 0; t < type->count; t++) {
+        if (!(type->array[t] & ECS_TOGGLE)) {
+            continue;
+        }
+        ecs_id_t id = type->array[t] & ~ECS_TOGGLE;
+        if (!ecs_is_enabled_id(world, e, id)) {
+            out.push_back(id);
+        }
+    }
+}
+
+// Mutation journals are append-only logs of the changes made to a world, with a
+// marker after every frame. Records are appended to a buffer that a background
+// thread writes out every flush interval, so a crash loses at most the records of
+// the last interval. Ids are written as they are in the recording world, preceded
+// by a definition record the first time they appear. Replay maps them to new ids.
+static const char JOURNAL_MAGIC[8] = {'F', 'L', 'E', 'C', 'S', 'J', 'N', 'L'};
+static const uint32_t JOURNAL_VERSION = 2;
+static const size_t JOURNAL_FLUSH_BYTES = 1 << 20;
+
+enum JournalOp : uint8_t {
+    JournalDefine = 1,  // entity, kind, name, native fields
+    JournalAdd,         // entity, id
+    JournalRemove,      // entity, id
+    JournalSetNative,   // entity, id, raw value
+    JournalSetPython,   // entity, id, pickled value
+    JournalName,        // entity, name
+    JournalDelete,      // entity
+    JournalFrame,       // frame number
+    JournalToggle       // entity, id, enabled
+};
+
+enum JournalKind : uint8_t {
+    JournalEntity,
+    JournalBuiltin,
+    JournalComponent,
+    JournalNativeComponent,
+    JournalPythonComponent
+};
+
+// Entities that are recreated by the bindings rather than replayed (systems,
+// observers, queries, modules and the members of native components)
+bool journal_skip(ecs_world_t* world, ecs_entity_t e) {
+    return ecs_has_id(world, e, ecs_id(EcsComponent)) || ecs_has_id(world, e, EcsModule) ||
+        ecs_has_id(world, e, ecs_id(EcsMember)) || ecs_has_pair(world, e, ecs_id(EcsPoly), EcsWildcard) ||
+        is_builtin_entity(world, e);
+}
+
+template <typename T>
+void record_value(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+void record_string(std::string& out, const std::string& str) {
+    record_value<uint32_t>(out, static_cast<uint32_t>(str.size()));
+    out.append(str);
+}
+
+// Components are recreated from their name (and native fields), other entities
+// are created anonymously and builtin entities have the same id in every world
+JournalKind definition_kind(ecs_world_t* world, ecs_entity_t e, std::vector<NativeField>& fields) {
+    if (!ecs_is_alive(world, e)) {
+        return JournalEntity;
+    }
+    if (is_builtin_entity(world, e)) {
+        return JournalBuiltin;
+    }
+    if (!ecs_has_id(world, e, ecs_id(EcsComponent)) || !ecs_get_name(world, e)) {
+        return JournalEntity;
+    }
+    fields = native_fields(world, e);
+    return is_py_component(world, e) ? JournalPythonComponent : 
+        !fields.empty() ? JournalNativeComponent : JournalComponent;
+}
+
+void write_definition(std::string& out, ecs_world_t* world, ecs_entity_t e, JournalKind kind, 
+    const std::vector<NativeField>& fields) 
+{
+    const char* entity_name = kind >= JournalComponent ? ecs_get_name(world, e) : nullptr;
+    record_value<uint64_t>(out, e);
+    record_value<uint8_t>(out, kind);
+    record_string(out, entity_name ? entity_name : "");
+    record_value<uint32_t>(out, static_cast<uint32_t>(fields.size()));
+    for (const NativeField& field : fields) {
+        record_string(out, field.name);
+        record_string(out, native_primitive_name(field.type));
+    }
+    record_value<uint8_t>(out, kind == JournalBuiltin ? 0 : storage_trait_mask(world, e));
+}
+
+// Pairs are written with the full ids of both elements, which carry the
+// generation that the pair itself doesn't have
+void record_id(std::string& out, ecs_world_t* world, ecs_id_t id) {
+    record_value<uint64_t>(out, id);
+    if (ECS_IS_PAIR(id)) {
+        record_value<uint64_t>(out, ecs_pair_first(world, id));
+        record_value<uint64_t>(out, ecs_pair_second(world, id));
+    }
+}
+
+// Read an id written by record_id and map it to this world, 0 if an element is unknown
+ecs_id_t read_mapped_id(ImageReader& reader, const std::unordered_map<ecs_entity_t, ecs_entity_t>& remap) {
+    auto map_entity = [&](ecs_entity_t e) -> ecs_entity_t {
+        auto found = remap.find(e);
+        return found == remap.end() ? 0 : found->second;
+    };
+    ecs_id_t id = reader.value<uint64_t>();
+    if (!ECS_IS_PAIR(id)) {
+        return map_entity(id);
+    }
+    ecs_entity_t first = map_entity(reader.value<uint64_t>());
+    ecs_entity_t second = map_entity(reader.value<uint64_t>());
+    return first && second ? ecs_pair(first, second) : 0;
+}
+
+struct Definition {
+    ecs_entity_t entity;
+    uint8_t kind;
+    std::string name;
+    py::dict fields;
+    uint8_t traits = 0;
+};
+
+Definition read_definition(ImageReader& reader) {
+    Definition definition;
+    definition.entity = reader.value<uint64_t>();
+    definition.kind = reader.value<uint8_t>();
+    definition.name = reader.string();
+    uint32_t field_count = reader.value<uint32_t>();
+    for (uint32_t f = 0; f < field_count; f++) {
+        std::string field_name = reader.string();
+        definition.fields[py::str(field_name)] = reader.string();
+    }
+    definition.traits = reader.value<uint8_t>();
+    return definition;
+}
+
+class MutationJournal {
+public:
+    ecs_world_t* world;
+    std::vector<ecs_entity_t> observers;
+    
+    MutationJournal(ecs_world_t* w, const std::string& path, double flush_interval) 
+        : world(w), interval(std::chrono::duration<double>(flush_interval)) 
+    {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Failed to open journal for writing: " + path);
+        }
+        pending.append(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        record_value(pending, JOURNAL_VERSION);
+        writer = std::thread([this] { write_loop(); });
+    }
+    
+    ~MutationJournal() {
+        close();
+    }
+    
+    // Write out the remaining records. Observers must be deleted before this.
+    void close() {
+        if (!writer.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        writer.join();
+        std::fclose(file);
+    }
+    
+    std::string error() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return write_error;
+    }
+    
+    void add(ecs_entity_t e, ecs_id_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string record;
+        define(record, e);
+        define_id(record, id);
+        record_value<uint8_t>(record, JournalAdd);
+        record_value<uint64_t>(record, e);
+        record_id(record, world, id);
+        append(record);
+    }
+    
+    void remove(ecs_entity_t e, ecs_id_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string record;
+        define(record, e);
+        define_id(record, id);
+        record_value<uint8_t>(record, JournalRemove);
+        record_value<uint64_t>(record, e);
+        record_id(record, world, id);
+        append(record);
+    }
+    
+    // Native values are stored as raw bytes, Python components are pickled
+    void set(ecs_entity_t e, ecs_id_t id) {
+        std::string payload;
+        uint8_t op = JournalSetNative;
+        if (is_py_component(world, id)) {
+            // Observers can run on a frame thread without the GIL
+            py::gil_scoped_acquire gil;
+            py::object obj = store_get(world, e, id);
+            if (!obj) {
+                return;
+            }
+            op = JournalSetPython;
+            payload = py::bytes(pickle_dumps()(obj, py::arg("protocol") = 5));
+        } else {
+            const ecs_type_info_t* type_info = ecs_get_type_info(world, id);
+            const void* ptr = ecs_get_id(world, e, id);
+            // Only trivially copyable values can be stored as raw bytes
+            if (!type_info || !ptr || type_info->hooks.ctor || type_info->hooks.dtor || 
+                type_info->hooks.copy || type_info->hooks.move) {
+                return;
+            }
+            payload.assign(static_cast<const char*>(ptr), static_cast<size_t>(type_info->size));
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string record;
+        define(record, e);
+        define_id(record, id);
+        record_value<uint8_t>(record, op);
+        record_value<uint64_t>(record, e);
+        record_id(record, world, id);
+        record_string(record, payload);
+        append(record);
+    }
+    
+    void name(ecs_entity_t e) {
+        const char* entity_name = ecs_get_name(world, e);
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string record;
+        define(record, e);
+        record_value<uint8_t>(record, JournalName);
+        record_value<uint64_t>(record, e);
+        record_string(record, entity_name ? entity_name : "");
+        append(record);
+    }
+    
+    // Enabling or disabling a CanToggle id emits no event, Entity.enable/disable
+    // record it directly
+    void toggle(ecs_entity_t e, ecs_id_t id, bool enabled) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string record;
+        define(record, e);
+        define_id(record, id);
+        record_value<uint8_t>(record, JournalToggle);
+        record_value<uint64_t>(record, e);
+        record_id(record, world, id);
+        record_value<uint8_t>(record, enabled ? 1 : 0);
+        append(record);
+    }
+    
+    void deleted(ecs_entity_t e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!defined.erase(e)) {
+            return;
+        }
+        std::string record;
+        record_value<uint8_t>(record, JournalDelete);
+        record_value<uint64_t>(record, e);
+        append(record);
+    }
+    
+    void frame(int64_t frame_number) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string record;
+        record_value<uint8_t>(record, JournalFrame);
+        record_value<int64_t>(record, frame_number);
+        append(record);
+    }
+    
+    // Record the current state of the world so the journal doesn't depend on what
+    // happened before it was started
+    void snapshot(flecs::query<>& entity_query) {
+        std::vector<ecs_entity_t> named;
+        std::vector<ecs_entity_t> non_fragmenting = non_fragmenting_ids(world);
+        ecs_iter_t it = ecs_query_iter(world, entity_query.c_ptr());
+        while (ecs_query_next(&it)) {
+            const ecs_type_t* type = ecs_table_get_type(it.table);
+            for (int i = 0; i < it.count; i++) {
+                ecs_entity_t e = it.entities[i];
+                std::vector<ecs_id_t> ids;
+                for (int32_t t = 0; t < type->count; t++) {
+                    ecs_id_t id = type->array[t];
+                    if ((id & ECS_ID_FLAGS_MASK & ~ECS_PAIR) ||
+                        (ECS_IS_PAIR(id) && ecs_pair_first(world, id) == ecs_id(EcsIdentifier))) {
+                        continue;
+                    }
+                    ids.push_back(id);
+                }
+                append_non_fragmenting(world, e, non_fragmenting, ids);
+                for (ecs_id_t id : ids) {
+                    add(e, id);
+                    if (ecs_get_type_info(world, id)) {
+                        set(e, id);
+                    }
+                }
+                
+                std::vector<ecs_id_t> disabled;
+                append_disabled_toggles(world, it.table, e, disabled);
+                for (ecs_id_t id : disabled) {
+                    toggle(e, id, false);
+                }
+                if (ecs_get_name(world, e)) {
+                    named.push_back(e);
+                }
+            }
+        }
+        // Names are set last, once entities are in their parent's scope
+        for (ecs_entity_t e : named) {
+            name(e);
+        }
+    }
+    
+private:
+    std::FILE* file;
+    std::chrono::duration<double> interval;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string pending;
+    std::string write_error;
+    bool stopping = false;
+    std::unordered_map<ecs_entity_t, JournalKind> defined;
+    
+    static py::object& pickle_dumps() {
+        static py::object dumps = py::module_::import("pickle").attr("dumps");
+        return dumps;
+    }
+    
+    void define_id(std::string& out, ecs_id_t id) {
+        if (ECS_IS_PAIR(id)) {
+            define(out, ecs_pair_first(world, id));
+            define(out, ecs_pair_second(world, id));
+        } else {
+            define(out, id & ECS_COMPONENT_MASK);
+        }
+    }
+    
+    // Components can be named entities before they become components, so an
+    // entity is defined again when its kind changes
+    void define(std::string& out, ecs_entity_t e) {
+        std::vector<NativeField> fields;
+        JournalKind kind = definition_kind(world, e, fields);
+        auto found = defined.find(e);
+        if (found != defined.end() && found->second == kind) {
+            return;
+        }
+        defined[e] = kind;
+        
+        record_value<uint8_t>(out, JournalDefine);
+        write_definition(out, world, e, kind, fields);
+    }
+    
+    void append(const std::string& record) {
+        pending.append(record);
+        if (pending.size() >= JOURNAL_FLUSH_BYTES) {
+            cv.notify_one();
+        }
+    }
+    
+    void write_loop() {
+        std::string chunk;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait_for(lock, interval, [this] { return stopping || pending.size() >= JOURNAL_FLUSH_BYTES; });
+            chunk.swap(pending);
+            bool stop = stopping;
+            lock.unlock();
+            
+            if (!chunk.empty() && write_error.empty()) {
+                if (std::fwrite(chunk.data(), 1, chunk.size(), file) != chunk.size() || std::fflush(file) != 0) {
+                    std::lock_guard<std::mutex> error_lock(mutex);
+                    write_error = "Failed to write journal";
+                }
+            }
+            chunk.clear();
+            if (stop) {
+                return;
+            }
+            lock.lock();
+        }
+    }
+};
+
+void JournalObserver(ecs_iter_t *it) {
+    MutationJournal* journal = static_cast<MutationJournal*>(it->ctx);
+    ecs_world_t* world = it->real_world;
+    ecs_id_t id = ecs_field_id(it, 0);
+    // The wildcard observer also sees pairs, which have their own observer
+    if (ECS_IS_PAIR(id) != ECS_IS_PAIR(it->query->terms[0].id) || (id & ECS_ID_FLAGS_MASK & ~ECS_PAIR)) {
+        return;
+    }
+    
+    bool is_name = false;
+    if (ECS_IS_PAIR(id) && ecs_pair_first(world, id) == ecs_id(EcsIdentifier)) {
+        // Names are the only identifiers that are recorded
+        if (ECS_PAIR_SECOND(id) != EcsName || it->event != EcsOnSet) {
+            return;
+        }
+        is_name = true;
+    }
+    
+    for (int i = 0; i < it->count; i++) {
+        ecs_entity_t e = it->entities[i];
+        if (journal_skip(world, e)) {
+            continue;
+        }
+        if (is_name) {
+            journal->name(e);
+        } else if (it->event == EcsOnAdd) {
+            journal->add(e, id);
+        } else if (it->event == EcsOnRemove) {
+            journal->remove(e, id);
+        } else {
+            journal->set(e, id);
+        }
+    }
+}
+
+void journal_deleted(const ecs_world_t* world, ecs_entity_t e) {
+    if (MutationJournal* journal = binding_state(world).journal) {
+        journal->deleted(e);
+    }
+}
+
+// World deltas keep mirrors of a world (e.g. a visualizer process) in sync without
+// exporting everything each tick. Structural changes are logged by observers.
+// Changed native columns are found with flecs table change detection and stamped
+// with the version of the first diff that saw them. A delta since version v holds
+// the entities and ids that changed after v and the columns of changed tables.
+static const char DELTA_MAGIC[8] = {'F', 'L', 'E', 'C', 'S', 'D', 'L', 'T'};
+static const uint32_t DELTA_VERSION = 2;
+static const size_t DELTA_LOG_LIMIT = 1 << 16;
+
+struct DeltaTracker {
+    struct Change {
+        uint64_t version;
+        ecs_entity_t entity;
+        // 0 when the entity was renamed
+        ecs_id_t id;
+        bool added;
+        // The entity kept the CanToggle id, added is whether it was enabled
+        bool toggled;
+    };
+    
+    // Change detecting query of a native component and the versions of its tables.
+    // Tables the query no longer matches are dropped each diff, as a table created
+    // later at the same address would otherwise inherit their version.
+    struct Column {
+        ecs_query_t* query = nullptr;
+        std::unordered_map<ecs_table_t*, uint64_t> versions;
+    };
+    
+    // Version of the last diff, changes logged since then get the next version
+    uint64_t version = 0;
+    std::deque<Change> log;
+    // Changes up to and including this version were dropped from the log
+    uint64_t log_floor = 0;
+    std::map<ecs_entity_t, Column> columns;
+    
+    // The log has a fixed limit, also when diff isn't called for a long time. Diffs
+    // since a version that was dropped raise, the mirror has to start over from 0.
+    void record(ecs_entity_t e, ecs_id_t id, bool added, bool toggled = false) {
+        log.push_back({version + 1, e, id, added, toggled});
+        while (log.size() > DELTA_LOG_LIMIT) {
+            log_floor = log.front().version;
+            log.pop_front();
+        }
+    }
+};
+
+void DeltaObserver(ecs_iter_t *it) {
+    DeltaTracker* tracker = static_cast<DeltaTracker*>(it->ctx);
+    ecs_world_t* world = it->real_world;
+    ecs_id_t id = ecs_field_id(it, 0);
+    // The wildcard observer also sees pairs, which have their own observer
+    if (ECS_IS_PAIR(id) != ECS_IS_PAIR(it->query->terms[0].id) || (id & ECS_ID_FLAGS_MASK & ~ECS_PAIR)) {
+        return;
+    }
+    
+    // OnSet is only observed for names. Python component values aren't replicated.
+    if (it->event == EcsOnSet) {
+        id = 0;
+    } else if ((ECS_IS_PAIR(id) && ecs_pair_first(world, id) == ecs_id(EcsIdentifier)) || is_py_component(world, id)) {
+        return;
+    }
+    
+    for (int i = 0; i < it->count; i++) {
+        if (!journal_skip(world, it->entities[i])) {
+            tracker->record(it->entities[i], id, it->event == EcsOnAdd);
+        }
+    }
+}
+
+void record_toggle(const ecs_world_t* world, ecs_entity_t e, ecs_id_t id, bool enabled) {
+    BindingState& state = binding_state(world);
+    state.toggle_version++;
+    if (state.journal) {
+        state.journal->toggle(e, id, enabled);
+    }
+    if (state.delta) {
+        state.delta->record(e, id, enabled, true);
+    }
+}
+
+// numpy dtype of a native field
+std::string shared_dtype(ecs_entity_t type) {
+    static const std::map<ecs_entity_t, std::string> dtypes = {
+        {ecs_id(ecs_bool_t), "?"},
+        {ecs_id(ecs_i8_t), "i1"}, {ecs_id(ecs_i16_t), "i2"},
+        {ecs_id(ecs_i32_t), "i4"}, {ecs_id(ecs_i64_t), "i8"},
+        {ecs_id(ecs_u8_t), "u1"}, {ecs_id(ecs_u16_t), "u2"},
+        {ecs_id(ecs_u32_t), "u4"}, {ecs_id(ecs_u64_t), "u8"},
+        {ecs_id(ecs_f32_t), "f4"}, {ecs_id(ecs_f64_t), "f8"},
+        {ecs_id(ecs_entity_t), "u8"}
+    };
+    auto it = dtypes.find(type);
+    if (it == dtypes.end()) {
+        throw std::runtime_error("Unsupported native field type: " + std::to_string(type));
+    }
+    return it->second;
+}
+
+// Native kernel for Query.parallel_for, e.g. a ctypes CFUNCTYPE. Receives the
+// rows of one chunk, a column pointer per query field (null for tags and Python
+// components) and a zeroed mask for selecting rows. Returns a partial result.
+typedef double (*ParallelKernel)(int32_t count, const uint64_t* entities, void* const* columns, uint8_t* mask);
+
+// Contiguous copy of a sparse field for one chunk
+struct GatheredField {
+    size_t size;
+    std::vector<char> values;
+    std::vector<void*> rows;
+    
+    void write_back() const {
+        for (size_t i = 0; i < rows.size(); i++) {
+            memcpy(rows[i], values.data() + i * size, size);
+        }
+    }
+};
+
+// Rows of one matched table, or a slice of a large one
+struct ParallelChunk {
+    const ecs_entity_t* entities;
+    int32_t count;
+    std::vector<void*> columns;
+    // Zero for fields matched on another entity
+    std::vector<size_t> strides;
+    // Ids of fields that are Python components, 0 for other fields
+    std::vector<ecs_id_t> py_ids;
+    // Copies of sparse fields, which have no column to point into. Written back
+    // to the rows they were read from once the kernels are done.
+    std::vector<GatheredField> gathered;
+};
+
+// Per-worker chunk queues. Workers take chunks from the front of their own queue
+// and steal from the back of the others' once it is empty, so a worker stuck on
+// a large table doesn't hold on to chunks other workers could run.
+class WorkStealingQueues {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> chunks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+    
+public:
+    WorkStealingQueues(size_t workers, size_t chunk_count) {
+        for (size_t w = 0; w < workers; w++) {
+            queues.emplace_back(new Queue());
+        }
+        // Contiguous ranges keep the chunks of a table on one worker
+        for (size_t c = 0; c < chunk_count; c++) {
+            queues[c * workers / chunk_count]->chunks.push_back(c);
+        }
+    }
+    
+    bool next(size_t worker, size_t& chunk) {
+        {
+            Queue& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.chunks.empty()) {
+                chunk = own.chunks.front();
+                own.chunks.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            Queue& victim = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.chunks.empty()) {
+                chunk = victim.chunks.back();
+                victim.chunks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+py::object PyQueryIterator::parallel_for(py::object kernel, int32_t threads, int32_t chunk_size, bool select) {
+    if (chunk_size <= 0) {
+        throw std::runtime_error("chunk_size must be positive");
+    }
+    if (threads <= 0) {
+        threads = static_cast<int32_t>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    
+    // ctypes functions and raw addresses run without the GIL
+    ParallelKernel native_kernel = nullptr;
+    if (py::isinstance<py::int_>(kernel) || py::hasattr(kernel, "argtypes")) {
+        py::object address = kernel;
+        if (!py::isinstance<py::int_>(kernel)) {
+            py::module_ ctypes = py::module_::import("ctypes");
+            address = ctypes.attr("cast")(kernel, ctypes.attr("c_void_p")).attr("value");
+        }
+        native_kernel = reinterpret_cast<ParallelKernel>(address.cast<uintptr_t>());
+        if (!native_kernel) {
+            throw std::runtime_error("Native kernel is a null function pointer");
+        }
+    } else if (select) {
+        throw std::runtime_error("select is only supported for native kernels");
+    }
+    if (!predicates.empty()) {
+        throw std::runtime_error("parallel_for doesn't apply where filters, test the values in the kernel instead");
+    }
+    
+    ecs_world_t* ecs = world.c_ptr();
+    size_t field_count = query_terms.size();
+    
+    // Split matched tables into chunks of at most chunk_size rows. Fields matched
+    // on another entity have the same value for every row and aren't advanced.
+    std::vector<ParallelChunk> chunks;
+    std::vector<int32_t> field_sizes(field_count, 0);
+    std::vector<ecs_entity_t> field_types(field_count, 0);
+    ecs_iter_t pit = query_iter();
+    while (ecs_query_next(&pit)) {
+        std::vector<void*> columns(field_count, nullptr);
+        std::vector<size_t> strides(field_count, 0);
+        std::vector<ecs_id_t> py_ids(field_count, 0);
+        std::vector<bool> sparse(field_count, false);
+        for (size_t f = 0; f < field_count; f++) {
+            int8_t field = static_cast<int8_t>(f);
+            size_t size = ecs_field_size(&pit, field);
+            ecs_id_t id = ecs_field_id(&pit, field);
+            if (!size || !ecs_field_is_set(&pit, field)) {
+                continue;
+            }
+            if (is_py_component(ecs, id)) {
+                py_ids[f] = ecs_field_is_self(&pit, field) ? id : 0;
+                continue;
+            }
+            // Sparse fields matched on another entity have one value, which can
+            // be pointed at directly like any other shared field
+            sparse[f] = is_sparse_id(ecs, id) && ecs_field_is_self(&pit, field);
+            if (sparse[f]) {
+                columns[f] = nullptr;
+            } else if (is_sparse_id(ecs, id)) {
+                columns[f] = ecs_field_at_w_size(&pit, size, field, 0);
+            } else {
+                columns[f] = ecs_field_w_size(&pit, size, field);
+            }
+            strides[f] = ecs_field_is_self(&pit, field) ? size : 0;
+            field_sizes[f] = static_cast<int32_t>(size);
+            field_types[f] = ecs_get_typeid(ecs, id);
+        }
+        for (int32_t offset = 0; offset < pit.count; offset += chunk_size) {
+            ParallelChunk chunk = {pit.entities + offset, std::min(chunk_size, pit.count - offset), columns, strides, py_ids};
+            for (size_t f = 0; f < field_count; f++) {
+                if (sparse[f]) {
+                    GatheredField& gathered = chunk.gathered.emplace_back();
+                    gathered.size = strides[f];
+                    gathered.values.resize(gathered.size * chunk.count);
+                    for (int32_t i = 0; i < chunk.count; i++) {
+                        void* row = ecs_field_at_w_size(&pit, gathered.size, static_cast<int8_t>(f), offset + i);
+                        memcpy(gathered.values.data() + i * gathered.size, row, gathered.size);
+                        gathered.rows.push_back(row);
+                    }
+                    chunk.columns[f] = gathered.values.data();
+                } else if (chunk.columns[f]) {
+                    chunk.columns[f] = static_cast<char*>(chunk.columns[f]) + strides[f] * offset;
+                }
+            }
+            chunks.push_back(std::move(chunk));
+        }
+    }
+    
+    // Python kernels get numpy views of native columns and lists of Python components
+    std::vector<py::object> dtypes(field_count);
+    if (!native_kernel) {
+        for (size_t f = 0; f < field_count; f++) {
+            if (!field_types[f]) {
+                continue;
+            }
+            py::list names, formats, offsets;
+            for (const NativeField& nf : native_fields(ecs, field_types[f])) {
+                names.append(nf.name);
+                formats.append(shared_dtype(nf.type));
+                offsets.append(nf.offset);
+            }
+            py::dict spec;
+            spec["names"] = names;
+            spec["formats"] = formats;
+            spec["offsets"] = offsets;
+            spec["itemsize"] = field_sizes[f];
+            dtypes[f] = py::dtype::from_args(spec);
+        }
+    }
+    
+    size_t workers = std::min(static_cast<size_t>(threads), std::max<size_t>(chunks.size(), 1));
+    WorkStealingQueues queues(workers, chunks.size());
+    std::vector<double> partials(chunks.size(), 0.0);
+    std::vector<std::vector<uint8_t>> masks(select ? chunks.size() : 0);
+    std::vector<py::object> results(native_kernel ? 0 : chunks.size());
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    // Field arrays are views of the table columns so kernels can write them. They are
+    // only valid during the kernel call, results that alias them are copied below.
+    py::capsule column_owner(chunks.data(), [](void*) {});
+    
+    auto run_python = [&](size_t c) {
+        const ParallelChunk& chunk = chunks[c];
+        py::gil_scoped_acquire gil;
+        py::list args;
+        // Entity ids are copied, kernels commonly return a slice of them
+        args.append(py::array_t<uint64_t>(chunk.count, chunk.entities));
+        for (size_t f = 0; f < field_count; f++) {
+            if (chunk.columns[f]) {
+                py::ssize_t stride = static_cast<py::ssize_t>(chunk.strides[f]);
+                args.append(py::array(dtypes[f], {chunk.count}, {stride}, chunk.columns[f], column_owner));
+            } else if (!chunk.py_ids[f]) {
+                args.append(py::none());
+            } else {
+                py::list values;
+                for (int32_t i = 0; i < chunk.count; i++) {
+                    py::object stored = store_get(ecs, chunk.entities[i], chunk.py_ids[f]);
+                    values.append(stored ? stored : py::none());
+                }
+                args.append(values);
+            }
+        }
+        results[c] = kernel(*args);
+    };
+    
+    auto run_worker = [&](size_t worker) {
+        size_t c;
+        while (!failed && queues.next(worker, c)) {
+            try {
+                if (native_kernel) {
+                    const ParallelChunk& chunk = chunks[c];
+                    uint8_t* mask = nullptr;
+                    if (select) {
+                        masks[c].assign(chunk.count, 0);
+                        mask = masks[c].data();
+                    }
+                    partials[c] = native_kernel(chunk.count, chunk.entities, chunk.columns.data(), mask);
+                } else {
+                    run_python(c);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+    
+    {
+        py::gil_scoped_release release;
+        std::vector<std::thread> pool;
+        for (size_t w = 1; w < workers; w++) {
+            pool.emplace_back(run_worker, w);
+        }
+        run_worker(0);
+        for (std::thread& t : pool) {
+            t.join();
+        }
+    }
+    // Kernels write table columns in place, sparse fields are stored here. This
+    // also runs after an error, like the column writes of chunks that finished.
+    for (const ParallelChunk& chunk : chunks) {
+        for (const GatheredField& gathered : chunk.gathered) {
+            gathered.write_back();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    
+    if (native_kernel) {
+        double total = 0.0;
+        for (double partial : partials) {
+            total += partial;
+        }
+        if (!select) {
+            return py::float_(total);
+        }
+        std::vector<ecs_entity_t> selected;
+        for (size_t c = 0; c < chunks.size(); c++) {
+            for (int32_t i = 0; i < chunks[c].count; i++) {
+                if (masks[c][i]) {
+                    selected.push_back(chunks[c].entities[i]);
+                }
+            }
+        }
+        return py::make_tuple(total, entity_id_array(selected.data(), selected.size()));
+    }
+    
+    // Arrays (e.g. filtered ids) are concatenated, which copies them out of the
+    // columns they may view. Other results are added up.
+    py::list arrays;
+    py::object total = py::none();
+    for (py::object& result : results) {
+        if (result.is_none()) {
+            continue;
+        }
+        if (py::isinstance<py::array>(result)) {
+            arrays.append(result);
+        } else {
+            total = total.is_none() ? result : total + result;
+        }
+    }
+    if (arrays.size()) {
+        return py::module_::import("numpy").attr("concatenate")(arrays);
+    }
+    return total;
+}
+
+// Shared memory exports let other processes (e.g. DataLoader workers) read native
+// columns and graph arrays without pickling. A segment holds a header and two data
+// slots. Each publish writes the slot the readers are not using and bumps a seqlock
+// style sequence number: odd while writing, publish n lives in slot n % 2.
+#ifndef _WIN32
+static const char SHARED_MAGIC[8] = {'F', 'L', 'E', 'C', 'S', 'S', 'H', 'M'};
+static const uint32_t SHARED_VERSION = 1;
+static const size_t SHARED_MAX_ARRAYS = 64;
+static const size_t SHARED_ALIGN = 64;
+
+struct SharedHeader {
+    char magic[8];
+    uint32_t version;
+    // Set when the writer replaced the segment with a larger one, readers reopen it by name
+    std::atomic<uint32_t> stale;
+    std::atomic<uint64_t> sequence;
+    uint64_t slot_capacity;
+};
+
+struct SharedArrayEntry {
+    char name[64];
+    char dtype[8];
+    uint32_t ndim;
+    uint32_t reserved;
+    int64_t shape[2];
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct SharedSlot {
+    uint32_t count;
+    uint32_t reserved;
+    SharedArrayEntry entries[SHARED_MAX_ARRAYS];
+};
+
+struct SharedArray {
+    std::string name;
+    std::string dtype;
+    std::vector<int64_t> shape;
+    size_t size;
+    // Only set for arrays kept between publishes (the graph), layouts leave it empty
+    std::vector<char> data;
+};
+
+size_t shared_align(size_t size) {
+    return (size + SHARED_ALIGN - 1) & ~(SHARED_ALIGN - 1);
+}
+
+// Bytes a slot needs to hold the arrays
+size_t shared_slot_size(const std::vector<SharedArray>& arrays) {
+    size_t size = shared_align(sizeof(SharedSlot));
+    for (const SharedArray& array : arrays) {
+        size += shared_align(array.size);
+    }
+    return size;
+}
+
+template <typename T>
+SharedArray shared_array(const std::string& name, const std::string& dtype, std::vector<int64_t> shape, const std::vector<T>& values) {
+    SharedArray array = {name, dtype, shape, values.size() * sizeof(T), std::vector<char>(values.size() * sizeof(T))};
+    if (!values.empty()) {
+        memcpy(array.data.data(), values.data(), array.data.size());
+    }
+    return array;
+}
+
+size_t shared_slot_offset(const SharedHeader* header, uint64_t slot) {
+    return shared_align(sizeof(SharedHeader)) + slot * header->slot_capacity;
+}
+
+std::string shared_name(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+// Writer side of a shared memory export, owned by the world that publishes it
+class SharedSegment {
+public:
+    std::string name;
+    SharedHeader* header = nullptr;
+    size_t size = 0;
+    
+    SharedSegment(const std::string& segment_name, size_t slot_capacity) : name(shared_name(segment_name)) {
+        create(slot_capacity);
+    }
+    
+    ~SharedSegment() {
+        release();
+        shm_unlink(name.c_str());
+    }
+    
+    // Publish arrays laid out as described. write(destinations) gets the address of
+    // each array in the free slot and fills them in place.
+    template <typename Write>
+    void publish(const std::vector<SharedArray>& arrays, Write&& write) {
+        if (arrays.size() > SHARED_MAX_ARRAYS) {
+            throw std::runtime_error("Too many arrays for shared export: " + name);
+        }
+        
+        size_t needed = shared_slot_size(arrays);
+        if (needed > header->slot_capacity) {
+            // Readers keep their old mapping until they see the stale flag
+            header->stale.store(1, std::memory_order_release);
+            release();
+            shm_unlink(name.c_str());
+            create(needed * 2);
+        }
+        
+        uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+        header->sequence.store(sequence + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        
+        char* slot_ptr = reinterpret_cast<char*>(header) + shared_slot_offset(header, (sequence / 2 + 1) % 2);
+        SharedSlot* slot = reinterpret_cast<SharedSlot*>(slot_ptr);
+        std::vector<char*> destinations(arrays.size());
+        size_t offset = shared_align(sizeof(SharedSlot));
+        slot->count = static_cast<uint32_t>(arrays.size());
+        for (size_t i = 0; i < arrays.size(); i++) {
+            const SharedArray& array = arrays[i];
+            SharedArrayEntry& entry = slot->entries[i];
+            memset(&entry, 0, sizeof(entry));
+            strncpy(entry.name, array.name.c_str(), sizeof(entry.name) - 1);
+            strncpy(entry.dtype, array.dtype.c_str(), sizeof(entry.dtype) - 1);
+            entry.ndim = static_cast<uint32_t>(array.shape.size());
+            for (size_t d = 0; d < array.shape.size() && d < 2; d++) {
+                entry.shape[d] = array.shape[d];
+            }
+            entry.offset = offset;
+            entry.size = array.size;
+            destinations[i] = slot_ptr + offset;
+            offset += shared_align(array.size);
+        }
+        
+        try {
+            write(destinations);
+        } catch (...) {
+            // Readers are still on the other slot, the half written one is never published
+            header->sequence.store(sequence, std::memory_order_release);
+            throw;
+        }
+        header->sequence.store(sequence + 2, std::memory_order_release);
+    }
+    
+private:
+    void create(size_t slot_capacity) {
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+        if (fd == -1) {
+            throw std::runtime_error("Failed to create shared memory segment: " + name);
+        }
+        size = shared_align(sizeof(SharedHeader)) + 2 * slot_capacity;
+        void* ptr = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (ptr == MAP_FAILED) {
+            shm_unlink(name.c_str());
+            throw std::runtime_error("Failed to map shared memory segment: " + name);
+        }
+        
+        header = static_cast<SharedHeader*>(ptr);
+        memcpy(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC));
+        header->version = SHARED_VERSION;
+        new (&header->stale) std::atomic<uint32_t>(0);
+        new (&header->sequence) std::atomic<uint64_t>(0);
+        header->slot_capacity = slot_capacity;
+        // Both slots start out empty so readers never see garbage
+        for (uint64_t slot = 0; slot < 2; slot++) {
+            reinterpret_cast<SharedSlot*>(reinterpret_cast<char*>(header) + shared_slot_offset(header, slot))->count = 0;
+        }
+    }
+    
+    void release() {
+        if (header) {
+            munmap(header, size);
+            header = nullptr;
+        }
+    }
+};
+
+// What a world publishes to a segment on every progress()
+struct SharedExport {
+    std::vector<ecs_entity_t> components;
+    bool graph;
+    std::unique_ptr<SharedSegment> segment;
+    // Change detecting query of all relationship tables. The graph arrays are only
+    // exported again after it reports a change.
+    ecs_query_t* graph_changes = nullptr;
+    std::vector<SharedArray> graph_arrays;
+};
+
+// Read-only mapping of a segment, shared by the arrays handed out by a SharedView
+struct SharedMapping {
+    const SharedHeader* header = nullptr;
+    size_t size = 0;
+    
+    ~SharedMapping() {
+        if (header) {
+            munmap(const_cast<SharedHeader*>(header), size);
+        }
+    }
+};
+
+// Reader side of a shared memory export, usable from any process
+class PySharedView {
+public:
+    std::string name;
+    std::shared_ptr<SharedMapping> mapping;
+    
+    PySharedView(const std::string& segment_name) : name(shared_name(segment_name)) {
+        open();
+    }
+    
+    // Number of publishes seen by the segment
+    uint64_t version() {
+        refresh();
+        return mapping->header->sequence.load(std::memory_order_acquire) / 2;
+    }
+    
+    // Arrays of the latest publish. With copy=False the arrays point into shared memory
+    // and stay valid until the writer has published twice more.
+    py::dict read(bool copy = true) {
+        while (true) {
+            refresh();
+            const SharedHeader* header = mapping->header;
+            uint64_t sequence = header->sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            
+            const char* slot_ptr = reinterpret_cast<const char*>(header) + shared_slot_offset(header, (sequence / 2) % 2);
+            const SharedSlot* slot = reinterpret_cast<const SharedSlot*>(slot_ptr);
+            py::capsule owner(new std::shared_ptr<SharedMapping>(mapping), [](void* ptr) {
+                delete static_cast<std::shared_ptr<SharedMapping>*>(ptr);
+            });
+            
+            py::dict result;
+            uint32_t count = std::min<uint32_t>(slot->count, SHARED_MAX_ARRAYS);
+            for (uint32_t i = 0; i < count; i++) {
+                const SharedArrayEntry& entry = slot->entries[i];
+                std::vector<py::ssize_t> shape(entry.shape, entry.shape + std::min<uint32_t>(entry.ndim, 2));
+                py::array array(py::dtype(std::string(entry.dtype)), shape, slot_ptr + entry.offset, owner);
+                if (copy) {
+                    result[py::str(entry.name)] = array.attr("copy")();
+                } else {
+                    array.attr("setflags")(py::arg("write") = false);
+                    result[py::str(entry.name)] = array;
+                }
+            }
+            
+            // The writer starts overwriting this slot at sequence + 3
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->sequence.load(std::memory_order_acquire) - sequence < 3) {
+                return result;
+            }
+        }
+    }
+    
+    void close() {
+        mapping.reset();
+    }
+    
+private:
+    void open() {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd == -1) {
+            throw std::runtime_error("No shared memory segment named " + name);
+        }
+        struct stat info;
+        void* ptr = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedHeader)) {
+            ptr = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (ptr == MAP_FAILED) {
+            throw std::runtime_error("Failed to map shared memory segment: " + name);
+        }
+        
+        mapping = std::make_shared<SharedMapping>();
+        mapping->header = static_cast<const SharedHeader*>(ptr);
+        mapping->size = static_cast<size_t>(info.st_size);
+        if (memcmp(mapping->header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC)) != 0 ||
+            mapping->header->version != SHARED_VERSION) {
+            mapping.reset();
+            throw std::runtime_error("Not a flecs shared memory segment: " + name);
+        }
+    }
+    
+    void refresh() {
+        if (!mapping || mapping->header->stale.load(std::memory_order_acquire)) {
+            open();
+        }
+    }
+};
+#endif
+
+// When and how often a system runs
+struct SystemSchedule {
+    ecs_entity_t phase = EcsOnUpdate;
+    float interval = 0.0f;
+    int32_t rate = 0;
+    ecs_entity_t tick_source = 0;
+    // Split matched entities over the world's worker threads
+    bool multi_threaded = false;
+};
+
+// Create a system entity in its pipeline phase and apply its frequency settings
+ecs_entity_t init_system_entity(flecs::world& world, ecs_system_desc_t& desc, const SystemSchedule& schedule) {
+    ecs_entity_t system_entity = ecs_new(world);
+    ecs_add_pair(world, system_entity, EcsDependsOn, schedule.phase);
+    ecs_add_id(world, system_entity, schedule.phase);
+    
+    desc.entity = system_entity;
+    desc.interval = schedule.interval;
+    desc.rate = schedule.rate;
+    desc.tick_source = schedule.tick_source;
+    desc.multi_threaded = schedule.multi_threaded;
+    return system_entity;
+}
+
+// Metrics sampled by world.enable_rest into the WorldMetrics singleton, so they can
+// be read over REST like any other component. Every member is 8 bytes, so the
+// layout matches the meta description created for it.
+struct WorldMetrics {
+    int64_t entities;
+    int64_t tables;
+    int64_t tables_created;
+    int64_t tables_deleted;
+    int64_t frames;
+    // Averages per frame since the previous sample, in seconds
+    double frame_time;
+    double system_time;
+    // Time the previous sample took, the overhead of sampling itself
+    double sample_time;
+};
+
+struct RestSampler {
+    ecs_entity_t component = 0;
+    ecs_entity_t system = 0;
+    ecs_world_info_t last = {};
+    double sample_time = 0.0;
+};
+
+void RestSampleRun(ecs_iter_t *it) {
+    int64_t start = trace_now();
+    RestSampler* sampler = static_cast<RestSampler*>(it->ctx);
+    const ecs_world_info_t* info = ecs_get_world_info(it->real_world);
+    
+    WorldMetrics metrics = {};
+    metrics.entities = ecs_get_entities(it->real_world).alive_count;
+    metrics.tables = info->table_count;
+    metrics.tables_created = info->table_create_total - sampler->last.table_create_total;
+    metrics.tables_deleted = info->table_delete_total - sampler->last.table_delete_total;
+    metrics.frames = info->frame_count_total - sampler->last.frame_count_total;
+    if (metrics.frames > 0) {
+        metrics.frame_time = (info->frame_time_total - sampler->last.frame_time_total) / metrics.frames;
+        metrics.system_time = (info->system_time_total - sampler->last.system_time_total) / metrics.frames;
+    }
+    metrics.sample_time = sampler->sample_time;
+    sampler->last = *info;
+    
+    ecs_set_id(it->world, sampler->component, sampler->component, sizeof(WorldMetrics), &metrics);
+    sampler->sample_time = static_cast<double>(trace_now() - start) * 1e-9;
+}
+
+// Simple wrapper for Flecs world
+class PyWorld {
+public:
+
+    // Python objects and callbacks of this world. Declared first so they outlive the
+    // world, whose cleanup still runs observers.
+    std::shared_ptr<BindingState> state = std::make_shared<BindingState>();
+
+    void shutdown_flecs_module() {
+        state->clear();
+    }
+
+#ifndef _WIN32
+    std::map<std::string, SharedExport> shared_exports;
+#endif
+    // Declared before world so it outlives the observer that updates it during world cleanup
+    std::unique_ptr<SpatialIndex> spatial_index;
+    // Live tag bitmaps by tag, also updated by observers
+    std::map<ecs_entity_t, std::shared_ptr<TagBitmap>> tag_sets;
+    // Context of the metrics sampling system and the REST bind address it points to
+    std::unique_ptr<RestSampler> rest_sampler;
+    std::string rest_bind;
+    // Last frame started with progress_async and the thread running it
+    std::shared_ptr<AsyncFrame> async_frame;
+    std::thread frame_thread;
+    // Mutation journal, its observers are deleted before it
+    std::unique_ptr<MutationJournal> journal;
+    // Change log for diff() and the id mapping of a mirror updated by apply_delta()
+    std::unique_ptr<DeltaTracker> delta_tracker;
+    std::unordered_map<ecs_entity_t, ecs_entity_t> delta_remap;
+    uint64_t delta_applied = 0;
+
+    flecs::world world;
+    
+    PyWorld() {
+        ecs_set_binding_ctx(world, state.get(), nullptr);
+    }
+    
+    // Create entity
+    PyEntity entity() {
+        return PyEntity(world.entity());
+    }
+
+    PyEntity entity(const std::string& name) {
+        return PyEntity(world.entity(name.c_str()));
+    }
+
+    PyEntity entity(const std::string& name, const py::list& components_and_tags) {
+        PyEntity entity = PyEntity(world.entity(name.c_str()));
+
+        for (auto item : components_and_tags) {
+            try {
+                py::object item_obj = item.cast<py::object>();
+                
+                if (py::isinstance<py::str>(item_obj)) {
+                    // Handle string as tag
+                    std::string tag_name = py::str(item_obj);
+                    entity.add_tag(tag_name);
+                }
+                else if (py::isinstance<py::tuple>(item_obj)) {
+                    // Handle tuple as relationship
+                    py::tuple rel_tuple = item_obj.cast<py::tuple>();
+                    
+                    if (rel_tuple.size() == 2) {
+                        // Two-element tuple: (relation, target)
+                        py::object relation = rel_tuple[0];
+                        py::object target = rel_tuple[1];
+                        
+                        if (py::isinstance<py::str>(relation) && py::isinstance<py::str>(target)) {
+                            // Both strings
+                            entity.add_relationship(relation.cast<std::string>(), target.cast<std::string>());
+                        }
+                        else if (py::isinstance<py::str>(relation) && py::isinstance<PyEntity>(target)) {
+                            // String relation, PyEntity target
+                            PyEntity target_entity = target.cast<PyEntity>();
+                            entity.add_relationship(relation.cast<std::string>(), target_entity);
+                        }
+                        else if (py::isinstance<PyEntity>(relation) && py::isinstance<py::str>(target)) {
+                            // PyEntity relation, string target
+                            PyEntity relation_entity = relation.cast<PyEntity>();
+                            entity.add_relationship(relation_entity, target.cast<std::string>());
+                        }
+                        else if (py::isinstance<PyEntity>(relation) && py::isinstance<PyEntity>(target)) {
+                            // Both PyEntity
+                            PyEntity relation_entity = relation.cast<PyEntity>();
+                            PyEntity target_entity = target.cast<PyEntity>();
+                            entity.add_relationship(relation_entity, target_entity);
+                        }
+                        else if (py::isinstance<py::str>(relation)) {
+                            // String relation, component target
+                            entity.add_relationship(relation.cast<std::string>(), target);
+                        }
+                        else if (py::isinstance<py::str>(target)) {
+                            // Component relation, string target
+                            entity.add_relationship(relation, target.cast<std::string>());
+                        }
+                        else {
+                            // Component relation, component target
+                            entity.add_relationship(relation, target);
+                        }
+                    }
+                    else {
+                        py::print("Warning: Relationship tuple must have exactly 2 elements, got", rel_tuple.size());
+                    }
+                }
+                else {
+                    // Handle as component instance
+                    entity.set_component_instance(item_obj);
+                }
+            } catch (const std::exception& e) {
+                py::print("Error processing component/tag/relationship:", e.what());
+            }
+        }
+        
+        return entity;
+    }
+
+    PyEntity component(const std::string& name) {
+        return PyEntity(world.component(name.c_str()));
+    }
+
+    // Create a native component from a {field: type} dictionary, e.g. {"x": "f32", "y": "f32"}
+    PyEntity component(const std::string& name, py::dict fields) {
+        return PyEntity(init_native_component(world, name, fields));
+    }
+
+    PyEntity prefab(const std::string& name) {
+        return PyEntity(world.prefab(name.c_str()));
     }
 
     PyEntity prefab(const std::string& name, const py::list& components_and_tags) {
@@ -1291,92 +5339,1541 @@ public:
             try {
                 py::object item_obj = item.cast<py::object>();
                 
-                if (py::isinstance<py::str>(item_obj)) {
-                    std::string tag_name = py::str(item_obj);
-                    prefab.add_tag(tag_name);
+                if (py::isinstance<py::str>(item_obj)) {
+                    std::string tag_name = py::str(item_obj);
+                    prefab.add_tag(tag_name);
+                }
+                else {
+                    prefab.set_component_instance(item_obj);
+                }
+            } catch (const std::exception& e) {
+                py::print("Error processing component/tag:", e.what());
+            }
+        }
+        
+        return prefab;
+    }
+
+    ~PyWorld() {
+        finish_async_frame();
+        state->delta = nullptr;
+        if (state->tracing.exchange(false)) {
+            trace_worlds--;
+        }
+        // Observers owned by Python objects are deleted by the world from here on
+        state->alive = false;
+        if (journal) {
+            for (ecs_entity_t observer : journal->observers) {
+                ecs_delete(world, observer);
+            }
+            state->journal = nullptr;
+            journal.reset();
+        }
+        state->clear();
+    }
+
+    // Batch observers are called with (entity ids, payload) instead of once per entity.
+    // Other observers get the payload of world.emit after their row, if there is one.
+    void create_observer(py::function callback, py::args args, py::list events = py::list(), bool batch = false) {
+        size_t callback_index;
+        {
+            BindingStateLock lock(*state);
+            callback_index = batch ? state->observer_batch_callbacks.size() : state->observer_callbacks.size();
+            if (batch) {
+                state->observer_batch_callbacks.push_back(callback);
+            } else {
+                state->observer_callbacks.push_back(callback);
+            }
+        }
+        
+        // Parse events list - default to OnAdd if empty
+        std::vector<ecs_entity_t> event_list;
+        if (events.size() == 0) {
+            event_list.push_back(EcsOnAdd);
+        } else {
+            for (auto event : events) {
+                event_list.push_back(entity_from_object(world, event));
+            }
+        }
+        
+        // Create observer for each event
+        // TODO: Only one observer, just set desc.events[i]
+        ecs_observer_desc_t desc = {};
+        desc.callback = batch ? PythonObserverBatchCallback : PythonObserverCallback;
+        desc.ctx = reinterpret_cast<void*>(callback_index);
+
+        int e_i = 0;
+        for (ecs_entity_t event : event_list) {
+            desc.events[e_i] = event;
+            e_i++;
+        }
+        
+        std::vector<QueryTerm> query_terms;
+        std::vector<std::string> var_names;
+        ecs_query_desc_t query_desc = generate_query_from_args(args, world, var_names, query_terms);
+        // ecs_query_t* query = ecs_query_init(world, &query_desc);
+        desc.query = query_desc;
+
+        if (!batch) {
+            PyQueryIterator py_query = PyQueryIterator(world, query_desc, var_names, query_terms);
+            BindingStateLock lock(*state);
+            state->observer_queries.push_back(py_query);
+        }
+
+        ecs_observer_init(world, &desc);
+    }
+
+    // Custom events are regular entities that observers can list in events=[...]
+    PyEntity event(const std::string& name) {
+        return PyEntity(world.entity(name.c_str()));
+    }
+
+    // Emit an event for many entities at once. Entities are grouped into runs of
+    // consecutive rows in the same table so that flecs is invoked once per run.
+    // The payload is passed to observers as is, component selects which observers
+    // match (by default observers for any component of the entity's table).
+    void emit(py::object event, py::array_t<int64_t, py::array::c_style | py::array::forcecast> ids,
+        py::object payload = py::none(), py::object component = py::none())
+    {
+        ecs_entity_t event_id = entity_from_object(world, event);
+        ecs_id_t component_id = component.is_none() ? 0 : entity_from_object(world, component);
+        
+        struct EmitRow {
+            ecs_table_t* table;
+            int32_t row;
+        };
+        std::vector<EmitRow> rows;
+        rows.reserve(static_cast<size_t>(ids.size()));
+        const int64_t* id_data = ids.data();
+        for (py::ssize_t i = 0; i < ids.size(); i++) {
+            ecs_record_t* record = ecs_record_find(world, static_cast<ecs_entity_t>(id_data[i]));
+            if (record && record->table) {
+                rows.push_back({record->table, static_cast<int32_t>(ECS_RECORD_TO_ROW(record->row))});
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const EmitRow& a, const EmitRow& b) {
+            return a.table != b.table ? a.table < b.table : a.row < b.row;
+        });
+        // Duplicate ids would otherwise deliver the event twice
+        rows.erase(std::unique(rows.begin(), rows.end(), [](const EmitRow& a, const EmitRow& b) {
+            return a.table == b.table && a.row == b.row;
+        }), rows.end());
+        
+        EmitBatch batch;
+        EmitBatch* outer_batch = active_emit_batch;
+        active_emit_batch = &batch;
+        
+        size_t run_start = 0;
+        for (size_t i = 1; i <= rows.size(); i++) {
+            bool run_ends = i == rows.size() || rows[i].table != rows[run_start].table ||
+                rows[i].row != rows[i - 1].row + 1;
+            if (!run_ends) {
+                continue;
+            }
+            ecs_table_t* table = rows[run_start].table;
+            ecs_type_t event_ids = component_id ? ecs_type_t{ &component_id, 1 } : *ecs_table_get_type(table);
+            ecs_event_desc_t desc = {};
+            desc.event = event_id;
+            desc.ids = &event_ids;
+            desc.table = table;
+            desc.offset = rows[run_start].row;
+            desc.count = rows[i - 1].row - rows[run_start].row + 1;
+            desc.param = payload.is_none() ? nullptr : payload.ptr();
+            ecs_emit(world, &desc);
+            run_start = i;
+        }
+        
+        active_emit_batch = outer_batch;
+        
+        for (auto& [callback_index, entities] : batch.entities) {
+            TraceSpan span(TraceObserver, 0, world);
+            py::object callback;
+            if (!registry_get(*state, state->observer_batch_callbacks, callback_index, callback)) {
+                continue;
+            }
+            try {
+                TracePythonScope python(span);
+                callback(entity_id_array(entities.data(), entities.size()), payload);
+            } catch (const std::exception& e) {
+                py::print("Error in batch observer callback:", e.what());
+            }
+        }
+    }
+
+    SystemSchedule system_schedule(py::object phase, float interval, int32_t rate, py::object tick_source) {
+        SystemSchedule schedule;
+        if (!phase.is_none()) {
+            schedule.phase = entity_from_object(world, phase);
+        }
+        if (!tick_source.is_none()) {
+            schedule.tick_source = entity_from_object(world, tick_source);
+        }
+        schedule.interval = interval;
+        schedule.rate = rate;
+        return schedule;
+    }
+
+    // Relationship used to order a cascade system, True selects ChildOf
+    ecs_entity_t cascade_relation_id(py::object cascade) {
+        if (cascade.is_none() || (py::isinstance<py::bool_>(cascade) && !cascade.cast<bool>())) {
+            return 0;
+        }
+        if (py::isinstance<py::bool_>(cascade)) {
+            return EcsChildOf;
+        }
+        ecs_entity_t relation = entity_from_object(world, cascade);
+        if (relation != EcsChildOf) {
+            ecs_add_id(world, relation, EcsTraversable);
+        }
+        return relation;
+    }
+
+    // Flatten the hierarchy below root into arrays of ids, parent indices and depths,
+    // in breadth-first or depth-first (pre-order) order
+    py::dict hierarchy(py::object root, py::object relation = py::none(), const std::string& order = "breadth") {
+        ecs_entity_t root_id = entity_from_object(world, root);
+        ecs_entity_t relation_id = relation.is_none() ? EcsChildOf : entity_from_object(world, relation);
+        if (order != "breadth" && order != "depth") {
+            throw std::runtime_error("Unknown hierarchy order: " + order);
+        }
+        
+        auto children_of = [&](ecs_entity_t parent, std::vector<ecs_entity_t>& children) {
+            children.clear();
+            if (relation_id == EcsChildOf) {
+                ecs_iter_t it = ecs_children(world, parent);
+                while (ecs_children_next(&it)) {
+                    children.insert(children.end(), it.entities, it.entities + it.count);
+                }
+            } else {
+                ecs_iter_t it = ecs_each_pair(world, relation_id, parent);
+                while (ecs_each_next(&it)) {
+                    children.insert(children.end(), it.entities, it.entities + it.count);
+                }
+            }
+        };
+        
+        std::vector<int64_t> ids;
+        std::vector<int32_t> parents;
+        std::vector<int32_t> depths;
+        // Non-ChildOf relationships can contain cycles
+        std::set<ecs_entity_t> visited = {root_id};
+        std::vector<ecs_entity_t> children;
+        
+        if (order == "breadth") {
+            ids.push_back(root_id);
+            parents.push_back(-1);
+            depths.push_back(0);
+            for (size_t head = 0; head < ids.size(); head++) {
+                children_of(ids[head], children);
+                for (ecs_entity_t child : children) {
+                    if (visited.insert(child).second) {
+                        ids.push_back(child);
+                        parents.push_back(static_cast<int32_t>(head));
+                        depths.push_back(depths[head] + 1);
+                    }
+                }
+            }
+        } else {
+            // (entity, parent index, depth)
+            std::vector<std::tuple<ecs_entity_t, int32_t, int32_t>> stack = {{root_id, -1, 0}};
+            while (!stack.empty()) {
+                auto [entity_id, parent, depth] = stack.back();
+                stack.pop_back();
+                int32_t index = static_cast<int32_t>(ids.size());
+                ids.push_back(entity_id);
+                parents.push_back(parent);
+                depths.push_back(depth);
+                
+                children_of(entity_id, children);
+                for (auto child = children.rbegin(); child != children.rend(); ++child) {
+                    if (visited.insert(*child).second) {
+                        stack.push_back({*child, index, depth + 1});
+                    }
+                }
+            }
+        }
+        
+        py::dict result;
+        result["ids"] = py::array_t<int64_t>(ids.size(), ids.data());
+        result["parent"] = py::array_t<int32_t>(parents.size(), parents.data());
+        result["depth"] = py::array_t<int32_t>(depths.size(), depths.data());
+        return result;
+    }
+
+    // Index a native position component in a uniform grid for proximity queries.
+    // fields defaults to the first (up to three) fields of the component.
+    void create_spatial_index(const std::string& component_name, float cell_size = 1.0f,
+        py::object fields = py::none(), int threads = 0)
+    {
+        flecs::entity component = world.lookup(component_name.c_str());
+        if (!component.is_valid() || native_fields(world, component.id()).empty()) {
+            throw std::runtime_error("Spatial index requires a native component: " + component_name);
+        }
+        if (!(cell_size > 0) || !std::isfinite(cell_size)) {
+            throw std::runtime_error("Spatial index cell_size must be positive and finite");
+        }
+        
+        std::vector<NativeField> position_fields;
+        if (fields.is_none()) {
+            for (const NativeField& field : native_fields(world, component.id())) {
+                if (position_fields.size() < 3) {
+                    position_fields.push_back(field);
+                }
+            }
+        } else {
+            for (auto field_name : fields) {
+                position_fields.push_back(native_field(world, component.id(), field_name.cast<std::string>()));
+            }
+        }
+        if (position_fields.empty() || position_fields.size() > 3) {
+            throw std::runtime_error("Spatial index needs 1 to 3 position fields");
+        }
+        
+        if (spatial_index) {
+            throw std::runtime_error("World already has a spatial index on " +
+                std::string(flecs::entity(world, spatial_index->component).path().c_str()) +
+                ", use rebuild_spatial_index() to refresh it");
+        }
+        size_t component_size = ecs_get_type_info(world, component.id())->size;
+        spatial_index = std::make_unique<SpatialIndex>(component.id(), position_fields, component_size, cell_size);
+        spatial_index->rebuild(world, threads);
+        
+        ecs_observer_desc_t desc = {};
+        desc.query.terms[0].id = component.id();
+        desc.events[0] = EcsOnSet;
+        desc.events[1] = EcsOnRemove;
+        desc.callback = SpatialIndexObserver;
+        desc.ctx = spatial_index.get();
+        spatial_index->observer = ecs_observer_init(world, &desc);
+    }
+
+    SpatialIndex& require_spatial_index() {
+        if (!spatial_index) {
+            throw std::runtime_error("No spatial index, create one with world.spatial_index()");
+        }
+        return *spatial_index;
+    }
+
+    // Rebuild the spatial index, e.g. after writing positions without set()/modified()
+    void rebuild_spatial_index(int threads = 0) {
+        require_spatial_index().rebuild(world, threads);
+    }
+
+    // Entities within radius of center
+    py::array_t<int64_t> within_radius(py::object center, float radius) {
+        SpatialIndex& index = require_spatial_index();
+        std::array<float, 3> point = index.point_from(center);
+        if (!SpatialIndex::is_finite(point) || !std::isfinite(radius) || radius < 0) {
+            throw std::runtime_error("within_radius needs a finite center and a finite, non-negative radius");
+        }
+        std::vector<ecs_entity_t> ids;
+        {
+            std::shared_lock<std::shared_mutex> lock(index.mutex);
+            ids = index.within_radius(point, radius);
+        }
+        py::array_t<int64_t> result(ids.size());
+        std::copy(ids.begin(), ids.end(), result.mutable_data());
+        return result;
+    }
+
+    // k nearest entities for each row of points, returns (ids, distances) arrays of
+    // shape (len(points), k). Missing neighbors have id -1 and distance inf.
+    py::tuple knn(py::array_t<float, py::array::c_style | py::array::forcecast> points, size_t k, int threads = 0) {
+        SpatialIndex& index = require_spatial_index();
+        if (points.ndim() == 1) {
+            points = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(
+                points.reshape({py::ssize_t(1), points.shape(0)}));
+        }
+        if (points.ndim() != 2) {
+            throw std::runtime_error("knn points must be a (n, dims) array");
+        }
+        
+        size_t count = static_cast<size_t>(points.shape(0));
+        size_t dims = std::min<size_t>(static_cast<size_t>(points.shape(1)), 3);
+        size_t stride = static_cast<size_t>(points.shape(1));
+        const float* data = points.data();
+        for (size_t i = 0; i < count; i++) {
+            for (size_t d = 0; d < dims; d++) {
+                if (!std::isfinite(data[i * stride + d])) {
+                    throw std::runtime_error("knn points must be finite");
+                }
+            }
+        }
+        
+        std::vector<int64_t> ids(count * k, -1);
+        std::vector<float> distances(count * k, std::numeric_limits<float>::infinity());
+        {
+            // Taken after releasing the GIL, an observer waiting for the index may hold it
+            py::gil_scoped_release release;
+            std::shared_lock<std::shared_mutex> lock(index.mutex);
+            SpatialIndex::parallel_for(count, threads, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    std::array<float, 3> point = {0, 0, 0};
+                    for (size_t d = 0; d < dims; d++) {
+                        point[d] = data[i * stride + d];
+                    }
+                    auto neighbors = index.knn(point, k);
+                    for (size_t n = 0; n < neighbors.size(); n++) {
+                        ids[i * k + n] = static_cast<int64_t>(neighbors[n].second);
+                        distances[i * k + n] = std::sqrt(neighbors[n].first);
+                    }
+                }
+            });
+        }
+        
+        std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(count), static_cast<py::ssize_t>(k)};
+        return py::make_tuple(py::array_t<int64_t>(shape, ids.data()), py::array_t<float>(shape, distances.data()));
+    }
+
+    // Write all user entities to a binary world image. Native columns are stored as raw
+    // page aligned blocks, Python components are pickled (protocol 5) with their
+    // buffers stored out of band. Systems and observers are not part of the image.
+    // Entities created by the application, without components, systems and modules
+    flecs::query<> user_entity_query() {
+        return world.query_builder<>()
+            .with(flecs::Any)
+            .without(flecs::ChildOf, "flecs").self().up()
+            .without(flecs::Module)
+            .without<flecs::Component>()
+            .without(ecs_id(EcsPoly), flecs::Wildcard)
+            .query_flags(EcsQueryMatchPrefab | EcsQueryMatchDisabled)
+            .build();
+    }
+
+    void save_image(const std::string& path) {
+        // Python and native components are recreated by name when loading
+        std::vector<ecs_entity_t> components;
+        std::set<ecs_entity_t> restorable;
+        ecs_iter_t component_it = ecs_each_id(world, ecs_id(EcsComponent));
+        while (ecs_each_next(&component_it)) {
+            for (int i = 0; i < component_it.count; i++) {
+                ecs_entity_t component = component_it.entities[i];
+                if (is_builtin_entity(world, component)) {
+                    continue;
+                }
+                if (is_py_component(world, component) || !native_fields(world, component).empty()) {
+                    components.push_back(component);
+                    restorable.insert(component);
+                }
+            }
+        }
+        
+        struct TableSlice {
+            ecs_table_t* table;
+            int32_t offset;
+            int32_t count;
+        };
+        std::vector<TableSlice> slices;
+        std::vector<ecs_entity_t> entities;
+        
+        flecs::query<> entity_query = user_entity_query();
+        ecs_iter_t it = ecs_query_iter(world, entity_query.c_ptr());
+        while (ecs_query_next(&it)) {
+            slices.push_back({it.table, it.offset, it.count});
+            for (int i = 0; i < it.count; i++) {
+                entities.push_back(it.entities[i]);
+                restorable.insert(it.entities[i]);
+            }
+        }
+        
+        // Prefabs are restored first so instances can inherit from them, before them
+        // the tags and relationships with storage traits that other tables use
+        std::stable_partition(slices.begin(), slices.end(), [&](const TableSlice& slice) {
+            return ecs_table_has_id(world, slice.table, EcsPrefab);
+        });
+        std::stable_partition(slices.begin(), slices.end(), [&](const TableSlice& slice) {
+            for (ecs_entity_t trait : storage_traits()) {
+                if (ecs_table_has_id(world, slice.table, trait)) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        
+        auto keep = [&](ecs_entity_t e) {
+            return restorable.count(e) || is_builtin_entity(world, e);
+        };
+        
+        ImageWriter writer(path);
+        writer.write(WORLD_IMAGE_MAGIC, sizeof(WORLD_IMAGE_MAGIC));
+        writer.value<uint32_t>(WORLD_IMAGE_VERSION);
+        writer.value<uint32_t>(WORLD_IMAGE_PAGE_SIZE);
+        
+        writer.value<uint64_t>(components.size());
+        for (ecs_entity_t component : components) {
+            std::vector<NativeField> fields = native_fields(world, component);
+            const char* name = ecs_get_name(world, component);
+            writer.value<uint64_t>(component);
+            writer.string(name ? name : "");
+            writer.value<uint8_t>(fields.empty() ? 0 : 1);
+            writer.value<uint32_t>(static_cast<uint32_t>(fields.size()));
+            for (const NativeField& field : fields) {
+                writer.string(field.name);
+                writer.string(native_primitive_name(field.type));
+            }
+            writer.value<uint8_t>(storage_trait_mask(world, component));
+        }
+        
+        writer.value<uint64_t>(entities.size());
+        for (ecs_entity_t entity_id : entities) {
+            const char* name = ecs_get_name(world, entity_id);
+            writer.value<uint64_t>(entity_id);
+            writer.string(name ? name : "");
+        }
+        
+        writer.value<uint64_t>(slices.size());
+        for (const TableSlice& slice : slices) {
+            // Sparse values aren't in a column, they are gathered per entity
+            struct IdRecord {
+                ecs_id_t id;
+                ecs_entity_t first;
+                ecs_entity_t second;
+                int32_t column;
+                bool sparse;
+                size_t size;
+            };
+            std::vector<IdRecord> records;
+            
+            const ecs_type_t* type = ecs_table_get_type(slice.table);
+            for (int32_t i = 0; i < type->count; i++) {
+                ecs_id_t id = type->array[i];
+                // Toggle entries are recreated with their CanToggle id
+                if (id & ECS_ID_FLAGS_MASK & ~ECS_PAIR) {
+                    continue;
+                }
+                IdRecord record = {id, id & ECS_COMPONENT_MASK, 0, -1, false, 0};
+                if (ECS_IS_PAIR(id)) {
+                    record.first = ecs_pair_first(world, id);
+                    record.second = ecs_pair_second(world, id);
+                    // Names are stored with the entity records
+                    if (record.first == ecs_id(EcsIdentifier) || !keep(record.first) || !keep(record.second)) {
+                        continue;
+                    }
+                } else if (!keep(record.first)) {
+                    continue;
+                }
+                
+                int32_t column = ecs_table_type_to_column_index(slice.table, i);
+                const ecs_type_info_t* type_info = ecs_get_type_info(world, id);
+                bool sparse = column == -1 && type_info && is_sparse_id(world, id);
+                if ((column != -1 || sparse) && !is_py_component(world, id)) {
+                    const ecs_type_hooks_t& hooks = type_info->hooks;
+                    // Only trivially copyable columns can be stored as raw bytes
+                    if (hooks.ctor || hooks.dtor || hooks.copy || hooks.move) {
+                        continue;
+                    }
+                    record.column = column;
+                    record.sparse = sparse;
+                    record.size = static_cast<size_t>(type_info->size);
                 }
-                else {
-                    prefab.set_component_instance(item_obj);
+                records.push_back(record);
+            }
+            
+            writer.value<uint32_t>(static_cast<uint32_t>(records.size()));
+            for (const IdRecord& record : records) {
+                writer.value<uint64_t>(record.id);
+                writer.value<uint64_t>(record.first);
+                writer.value<uint64_t>(record.second);
+                writer.value<uint8_t>(record.column != -1 || record.sparse ? 1 : 0);
+            }
+            
+            const ecs_entity_t* slice_entities = ecs_table_entities(slice.table) + slice.offset;
+            writer.value<uint32_t>(static_cast<uint32_t>(slice.count));
+            writer.block(slice_entities, slice.count * sizeof(ecs_entity_t));
+            for (const IdRecord& record : records) {
+                if (record.column != -1) {
+                    writer.block(ecs_table_get_column(slice.table, record.column, slice.offset), slice.count * record.size);
+                } else if (record.sparse) {
+                    std::vector<char> values(slice.count * record.size);
+                    for (int32_t row = 0; row < slice.count; row++) {
+                        memcpy(values.data() + row * record.size, ecs_get_id(world, slice_entities[row], record.id), record.size);
+                    }
+                    writer.block(values.data(), values.size());
                 }
-            } catch (const std::exception& e) {
-                py::print("Error processing component/tag:", e.what());
             }
         }
         
-        return prefab;
+        // Non-fragmenting ids aren't in the table types, they are written per entity
+        // with their value. Python components are restored with the pickled objects.
+        struct NonFragmentingRecord {
+            ecs_entity_t entity;
+            ecs_id_t id;
+            ecs_entity_t first;
+            ecs_entity_t second;
+            std::string value;
+        };
+        std::vector<NonFragmentingRecord> non_fragmenting_records;
+        std::vector<ecs_entity_t> non_fragmenting = non_fragmenting_ids(world);
+        if (!non_fragmenting.empty()) {
+            for (ecs_entity_t entity_id : entities) {
+                std::vector<ecs_id_t> ids;
+                append_non_fragmenting(world, entity_id, non_fragmenting, ids);
+                for (ecs_id_t id : ids) {
+                    NonFragmentingRecord record = {entity_id, id, id & ECS_COMPONENT_MASK, 0, std::string()};
+                    if (ECS_IS_PAIR(id)) {
+                        record.first = ecs_pair_first(world, id);
+                        record.second = ecs_pair_second(world, id);
+                    }
+                    if (!keep(record.first) || (record.second && !keep(record.second)) || is_py_component(world, id)) {
+                        continue;
+                    }
+                    const ecs_type_info_t* type_info = ecs_get_type_info(world, id);
+                    if (type_info) {
+                        const ecs_type_hooks_t& hooks = type_info->hooks;
+                        if (hooks.ctor || hooks.dtor || hooks.copy || hooks.move) {
+                            continue;
+                        }
+                        record.value.assign(static_cast<const char*>(ecs_get_id(world, entity_id, id)),
+                            static_cast<size_t>(type_info->size));
+                    }
+                    non_fragmenting_records.push_back(record);
+                }
+            }
+        }
+        writer.value<uint64_t>(non_fragmenting_records.size());
+        for (const NonFragmentingRecord& record : non_fragmenting_records) {
+            writer.value<uint64_t>(record.entity);
+            writer.value<uint64_t>(record.id);
+            writer.value<uint64_t>(record.first);
+            writer.value<uint64_t>(record.second);
+            writer.string(record.value);
+        }
+        
+        // Disabled CanToggle ids, their enable bits aren't in a column
+        std::vector<std::pair<ecs_entity_t, ecs_id_t>> disabled_records;
+        for (const TableSlice& slice : slices) {
+            const ecs_entity_t* slice_entities = ecs_table_entities(slice.table) + slice.offset;
+            for (int32_t row = 0; row < slice.count; row++) {
+                std::vector<ecs_id_t> disabled;
+                append_disabled_toggles(world, slice.table, slice_entities[row], disabled);
+                for (ecs_id_t id : disabled) {
+                    disabled_records.push_back({slice_entities[row], id});
+                }
+            }
+        }
+        writer.value<uint64_t>(disabled_records.size());
+        for (const auto& [entity_id, id] : disabled_records) {
+            writer.value<uint64_t>(entity_id);
+            writer.value<uint64_t>(id);
+            writer.value<uint64_t>(ECS_IS_PAIR(id) ? ecs_pair_first(world, id) : id);
+            writer.value<uint64_t>(ECS_IS_PAIR(id) ? ecs_pair_second(world, id) : 0);
+        }
+        
+        // Python components
+        py::module_ pickle = py::module_::import("pickle");
+        struct PickledObject {
+            ecs_entity_t entity;
+            ecs_id_t id;
+            ecs_entity_t first;
+            ecs_entity_t second;
+            py::object object;
+            py::bytes payload;
+            py::list buffers;
+        };
+        std::vector<PickledObject> objects;
+        {
+            BindingStateLock lock(*state);
+            for (ecs_entity_t entity_id : entities) {
+                auto stored = state->component_objects.find(entity_id);
+                if (stored == state->component_objects.end()) {
+                    continue;
+                }
+                for (const auto& [id, obj] : stored->second) {
+                    PickledObject pickled = {entity_id, id, id & ECS_COMPONENT_MASK, 0, obj, py::bytes(), py::list()};
+                    if (ECS_IS_PAIR(id)) {
+                        pickled.first = ecs_pair_first(world, id);
+                        pickled.second = ecs_pair_second(world, id);
+                    }
+                    if (keep(pickled.first) && (!pickled.second || keep(pickled.second))) {
+                        objects.push_back(pickled);
+                    }
+                }
+            }
+        }
+        for (PickledObject& pickled : objects) {
+            pickled.payload = pickle.attr("dumps")(pickled.object, py::arg("protocol") = 5,
+                py::arg("buffer_callback") = pickled.buffers.attr("append"));
+        }
+        
+        writer.value<uint64_t>(objects.size());
+        for (const PickledObject& pickled : objects) {
+            writer.value<uint64_t>(pickled.entity);
+            writer.value<uint64_t>(pickled.id);
+            writer.value<uint64_t>(pickled.first);
+            writer.value<uint64_t>(pickled.second);
+            
+            std::string payload = pickled.payload;
+            writer.value<uint64_t>(payload.size());
+            writer.block(payload.data(), payload.size());
+            
+            writer.value<uint32_t>(static_cast<uint32_t>(pickled.buffers.size()));
+            for (auto buffer : pickled.buffers) {
+                py::buffer raw = buffer.attr("raw")();
+                py::buffer_info info = raw.request();
+                size_t size = static_cast<size_t>(info.size * info.itemsize);
+                writer.value<uint64_t>(size);
+                writer.block(info.ptr, size);
+            }
+        }
     }
 
-    ~PyWorld() {
-        flecs_component_pyobject.clear();
-        observer_callbacks.clear();
-        system_callbacks.clear();
-        observer_iter_callbacks.clear();
-        system_iter_callbacks.clear();
+    // Create a world from an image written by save_image. The file is memory mapped,
+    // native columns are bulk inserted straight from the mapping and out of band
+    // pickle buffers (e.g. numpy arrays) keep referencing it without a copy.
+    static std::unique_ptr<PyWorld> load_image(const std::string& path) {
+        std::unique_ptr<PyWorld> result = std::make_unique<PyWorld>();
+        result->read_image(path);
+        return result;
     }
 
-    void create_observer(py::function callback, py::args args, py::list events = py::list()) {
-        size_t callback_index = observer_callbacks.size();
-        observer_callbacks.push_back(callback);
+    void read_image(const std::string& path) {
+        py::module_ mmap_module = py::module_::import("mmap");
+        py::object file = py::module_::import("io").attr("open")(path, "rb");
+        py::object mapping = mmap_module.attr("mmap")(file.attr("fileno")(), 0,
+            py::arg("access") = mmap_module.attr("ACCESS_COPY"));
+        file.attr("close")();
         
-        // Parse events list - default to OnAdd if empty
-        std::vector<ecs_entity_t> event_list;
-        if (events.size() == 0) {
-            event_list.push_back(EcsOnAdd);
-        } else {
-            for (auto event : events) {
-                ecs_entity_t event_id = event.cast<ecs_entity_t>();
-                event_list.push_back(event_id);
+        py::object view = py::reinterpret_steal<py::object>(PyMemoryView_FromObject(mapping.ptr()));
+        py::buffer_info info = py::reinterpret_borrow<py::buffer>(view).request();
+        const char* base = static_cast<const char*>(info.ptr);
+        ImageReader reader(base, static_cast<size_t>(info.size));
+        
+        if (memcmp(reader.read(sizeof(WORLD_IMAGE_MAGIC)), WORLD_IMAGE_MAGIC, sizeof(WORLD_IMAGE_MAGIC)) != 0) {
+            throw std::runtime_error("Not a world image: " + path);
+        }
+        if (reader.value<uint32_t>() != WORLD_IMAGE_VERSION || reader.value<uint32_t>() != WORLD_IMAGE_PAGE_SIZE) {
+            throw std::runtime_error("Unsupported world image version: " + path);
+        }
+        
+        // Entity ids from the image are remapped, builtin ids are the same in every world
+        std::unordered_map<ecs_entity_t, ecs_entity_t> remap;
+        auto map_entity = [&](ecs_entity_t e) -> ecs_entity_t {
+            auto found = remap.find(e);
+            if (found != remap.end()) {
+                return found->second;
             }
+            return ecs_is_alive(world, e) ? e : 0;
+        };
+        auto map_id = [&](ecs_id_t id, ecs_entity_t first, ecs_entity_t second) -> ecs_id_t {
+            ecs_entity_t new_first = map_entity(first);
+            if (!new_first) {
+                return 0;
+            }
+            if (ECS_IS_PAIR(id)) {
+                ecs_entity_t new_second = map_entity(second);
+                return new_second ? ecs_pair(new_first, new_second) | (id & ECS_ID_FLAGS_MASK) : 0;
+            }
+            return new_first | (id & ECS_ID_FLAGS_MASK);
+        };
+        
+        uint64_t component_count = reader.value<uint64_t>();
+        for (uint64_t c = 0; c < component_count; c++) {
+            ecs_entity_t old_id = reader.value<uint64_t>();
+            std::string name = reader.string();
+            uint8_t is_native = reader.value<uint8_t>();
+            uint32_t field_count = reader.value<uint32_t>();
+            py::dict fields;
+            for (uint32_t f = 0; f < field_count; f++) {
+                std::string field_name = reader.string();
+                fields[py::str(field_name)] = reader.string();
+            }
+            uint8_t traits = reader.value<uint8_t>();
+            remap[old_id] = is_native ? component(name, fields).entity.id() : py_component_entity(world, name).id();
+            add_storage_traits(world, remap[old_id], traits);
         }
         
-        // Create observer for each event
-        // TODO: Only one observer, just set desc.events[i]
-        ecs_observer_desc_t desc = {};
-        desc.callback = PythonObserverCallback;
-        desc.ctx = reinterpret_cast<void*>(callback_index);
+        uint64_t entity_count = reader.value<uint64_t>();
+        std::vector<std::pair<ecs_entity_t, std::string>> names;
+        remap.reserve(remap.size() + entity_count);
+        for (uint64_t e = 0; e < entity_count; e++) {
+            ecs_entity_t old_id = reader.value<uint64_t>();
+            ecs_entity_t new_id = ecs_new(world);
+            remap[old_id] = new_id;
+            std::string name = reader.string();
+            if (!name.empty()) {
+                names.push_back({new_id, name});
+            }
+        }
+        
+        uint64_t table_count = reader.value<uint64_t>();
+        for (uint64_t t = 0; t < table_count; t++) {
+            uint32_t id_count = reader.value<uint32_t>();
+            std::vector<ecs_id_t> ids;
+            std::vector<bool> has_data;
+            for (uint32_t i = 0; i < id_count; i++) {
+                ecs_id_t id = reader.value<uint64_t>();
+                ecs_entity_t first = reader.value<uint64_t>();
+                ecs_entity_t second = reader.value<uint64_t>();
+                ids.push_back(map_id(id, first, second));
+                has_data.push_back(reader.value<uint8_t>() != 0);
+            }
+            
+            int32_t count = static_cast<int32_t>(reader.value<uint32_t>());
+            const ecs_entity_t* old_entities = reinterpret_cast<const ecs_entity_t*>(
+                base + reader.block(count * sizeof(ecs_entity_t)));
+            std::vector<ecs_entity_t> new_entities(count);
+            for (int32_t i = 0; i < count; i++) {
+                new_entities[i] = map_entity(old_entities[i]);
+            }
+            
+            // Sparse ids are set per entity after the bulk insert of the others
+            std::vector<ecs_id_t> table_ids;
+            std::vector<void*> table_data;
+            std::vector<size_t> table_sizes;
+            std::vector<ecs_id_t> sparse_ids;
+            std::vector<void*> sparse_data;
+            std::vector<size_t> sparse_sizes;
+            for (uint32_t i = 0; i < id_count; i++) {
+                void* data = nullptr;
+                size_t size = 0;
+                if (has_data[i]) {
+                    const ecs_type_info_t* type_info = ids[i] ? ecs_get_type_info(world, ids[i]) : nullptr;
+                    if (!type_info) {
+                        throw std::runtime_error("World image column has no component in this world");
+                    }
+                    size = static_cast<size_t>(type_info->size);
+                    data = const_cast<char*>(base + reader.block(count * size));
+                }
+                if (ids[i] && is_sparse_id(world, ids[i])) {
+                    sparse_ids.push_back(ids[i]);
+                    sparse_data.push_back(data);
+                    sparse_sizes.push_back(size);
+                } else if (ids[i]) {
+                    table_ids.push_back(ids[i]);
+                    table_data.push_back(data);
+                    table_sizes.push_back(size);
+                }
+            }
+            
+            if ((table_ids.empty() && sparse_ids.empty()) || count == 0) {
+                continue;
+            }
+            
+            // Insert all entities of the table in one operation
+            size_t bulk_count = std::min<size_t>(table_ids.size(), FLECS_ID_DESC_MAX);
+            if (bulk_count) {
+                ecs_bulk_desc_t desc = {};
+                desc.entities = new_entities.data();
+                desc.count = count;
+                for (size_t i = 0; i < bulk_count; i++) {
+                    desc.ids[i] = table_ids[i];
+                }
+                desc.data = table_data.data();
+                ecs_bulk_init(world, &desc);
+            }
+            
+            table_ids.insert(table_ids.end(), sparse_ids.begin(), sparse_ids.end());
+            table_data.insert(table_data.end(), sparse_data.begin(), sparse_data.end());
+            table_sizes.insert(table_sizes.end(), sparse_sizes.begin(), sparse_sizes.end());
+            for (size_t i = bulk_count; i < table_ids.size(); i++) {
+                for (int32_t row = 0; row < count; row++) {
+                    if (table_data[i]) {
+                        ecs_set_id(world, new_entities[row], table_ids[i], table_sizes[i],
+                            static_cast<char*>(table_data[i]) + row * table_sizes[i]);
+                    } else {
+                        ecs_add_id(world, new_entities[row], table_ids[i]);
+                    }
+                }
+            }
+        }
+        
+        uint64_t non_fragmenting_count = reader.value<uint64_t>();
+        for (uint64_t n = 0; n < non_fragmenting_count; n++) {
+            ecs_entity_t entity_id = map_entity(reader.value<uint64_t>());
+            ecs_id_t old_id = reader.value<uint64_t>();
+            ecs_entity_t first = reader.value<uint64_t>();
+            ecs_entity_t second = reader.value<uint64_t>();
+            std::string value = reader.string();
+            ecs_id_t id = map_id(old_id, first, second);
+            if (!entity_id || !id) {
+                continue;
+            }
+            const ecs_type_info_t* type_info = ecs_get_type_info(world, id);
+            if (type_info && static_cast<size_t>(type_info->size) == value.size()) {
+                ecs_set_id(world, entity_id, id, value.size(), value.data());
+            } else {
+                ecs_add_id(world, entity_id, id);
+            }
+        }
+        
+        uint64_t disabled_count = reader.value<uint64_t>();
+        for (uint64_t d = 0; d < disabled_count; d++) {
+            ecs_entity_t entity_id = map_entity(reader.value<uint64_t>());
+            ecs_id_t old_id = reader.value<uint64_t>();
+            ecs_entity_t first = reader.value<uint64_t>();
+            ecs_entity_t second = reader.value<uint64_t>();
+            ecs_id_t id = map_id(old_id, first, second);
+            if (entity_id && id && ecs_has_id(world, entity_id, id)) {
+                ecs_enable_id(world, entity_id, id, false);
+            }
+        }
+        
+        py::module_ pickle = py::module_::import("pickle");
+        auto slice = [&](size_t offset, size_t size) -> py::object {
+            return view[py::slice(static_cast<py::ssize_t>(offset), static_cast<py::ssize_t>(offset + size), 1)];
+        };
+        
+        uint64_t object_count = reader.value<uint64_t>();
+        for (uint64_t o = 0; o < object_count; o++) {
+            ecs_entity_t old_entity = reader.value<uint64_t>();
+            ecs_id_t old_id = reader.value<uint64_t>();
+            ecs_entity_t first = reader.value<uint64_t>();
+            ecs_entity_t second = reader.value<uint64_t>();
+            uint64_t payload_size = reader.value<uint64_t>();
+            size_t payload_offset = reader.block(payload_size);
+            
+            py::list buffers;
+            uint32_t buffer_count = reader.value<uint32_t>();
+            for (uint32_t b = 0; b < buffer_count; b++) {
+                uint64_t size = reader.value<uint64_t>();
+                buffers.append(slice(reader.block(size), size));
+            }
+            
+            ecs_entity_t entity_id = map_entity(old_entity);
+            ecs_id_t id = map_id(old_id, first, second);
+            if (!entity_id || !id) {
+                continue;
+            }
+            
+            py::object obj = pickle.attr("loads")(slice(payload_offset, payload_size), py::arg("buffers") = buffers);
+            store_set(world, entity_id, id, obj);
+            if (is_py_component(world, id)) {
+                PyComponentRef ref = { obj.ptr() };
+                ecs_set_id(world, entity_id, id, sizeof(PyComponentRef), &ref);
+            }
+        }
+        
+        // Names are set last, once entities are in their parent's scope
+        for (const auto& [entity_id, name] : names) {
+            ecs_set_name(world, entity_id, name.c_str());
+        }
+    }
 
-        int e_i = 0;
-        for (ecs_entity_t event : event_list) {
-            desc.events[e_i] = event;
-            e_i++;
+    // Record every change made to the world to an append-only journal, starting
+    // with its current state. World.replay rebuilds a world from the journal.
+    // Python components are recorded when they are set or written through a tracked
+    // component (get(T, track=True)), in-place changes to a plain object emit no OnSet.
+    void start_journal(const std::string& path, double flush_interval = 0.1) {
+        stop_journal();
+        
+        journal = std::make_unique<MutationJournal>(world, path, flush_interval);
+        flecs::query<> entity_query = user_entity_query();
+        journal->snapshot(entity_query);
+        
+        // Plain ids and pairs are observed separately
+        ecs_id_t observed[2] = {EcsWildcard, ecs_pair(EcsWildcard, EcsWildcard)};
+        for (ecs_id_t id : observed) {
+            ecs_observer_desc_t desc = {};
+            desc.query.terms[0].id = id;
+            desc.query.flags = EcsQueryMatchPrefab | EcsQueryMatchDisabled;
+            desc.events[0] = EcsOnAdd;
+            desc.events[1] = EcsOnRemove;
+            desc.events[2] = EcsOnSet;
+            desc.callback = JournalObserver;
+            desc.ctx = journal.get();
+            journal->observers.push_back(ecs_observer_init(world, &desc));
+        }
+        state->journal = journal.get();
+    }
+    
+    // Write out the buffered records and close the journal
+    void stop_journal() {
+        if (!journal) {
+            return;
+        }
+        for (ecs_entity_t observer : journal->observers) {
+            ecs_delete(world, observer);
+        }
+        state->journal = nullptr;
+        
+        std::unique_ptr<MutationJournal> closing = std::move(journal);
+        closing->close();
+        std::string error = closing->error();
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+    
+    // Map a journal or delta definition to an entity of this world
+    ecs_entity_t define_entity(const Definition& definition, std::unordered_map<ecs_entity_t, ecs_entity_t>& remap) {
+        auto found = remap.find(definition.entity);
+        ecs_entity_t defined = found == remap.end() ? 0 : found->second;
+        // Deltas define their components every time
+        if (defined && definition.kind >= JournalComponent && ecs_has_id(world, defined, ecs_id(EcsComponent))) {
+            add_storage_traits(world, defined, definition.traits);
+            return defined;
+        }
+        if (definition.kind == JournalBuiltin) {
+            defined = ecs_is_alive(world, definition.entity) ? definition.entity : 0;
+        } else if (definition.kind == JournalComponent) {
+            defined = component(definition.name).entity.id();
+        } else if (definition.kind == JournalNativeComponent) {
+            defined = component(definition.name, definition.fields).entity.id();
+        } else if (definition.kind == JournalPythonComponent) {
+            defined = py_component_entity(world, definition.name).id();
+        } else if (!defined) {
+            defined = ecs_new(world);
+        }
+        if (defined && definition.kind != JournalBuiltin) {
+            add_storage_traits(world, defined, definition.traits);
+        }
+        remap[definition.entity] = defined;
+        return defined;
+    }
+    
+    // Create a world from a journal written by start_journal. Records are applied
+    // without running systems, up to and including the marker of frame until_frame
+    // (all records if it is -1). A record cut off by a crash ends the replay.
+    static std::unique_ptr<PyWorld> replay(const std::string& path, int64_t until_frame = -1) {
+        std::unique_ptr<PyWorld> result = std::make_unique<PyWorld>();
+        result->replay_journal(path, until_frame);
+        return result;
+    }
+    
+    void replay_journal(const std::string& path, int64_t until_frame) {
+        std::string data;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            throw std::runtime_error("Failed to open journal: " + path);
+        }
+        char buffer[1 << 16];
+        size_t read_size;
+        while ((read_size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.append(buffer, read_size);
+        }
+        std::fclose(file);
+        
+        ImageReader reader(data.data(), data.size());
+        if (data.size() < sizeof(JOURNAL_MAGIC) + sizeof(uint32_t) ||
+            memcmp(reader.read(sizeof(JOURNAL_MAGIC)), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+            throw std::runtime_error("Not a journal: " + path);
+        }
+        if (reader.value<uint32_t>() != JOURNAL_VERSION) {
+            throw std::runtime_error("Unsupported journal version: " + path);
+        }
+        
+        std::unordered_map<ecs_entity_t, ecs_entity_t> remap;
+        auto map_entity = [&](ecs_entity_t e) -> ecs_entity_t {
+            auto found = remap.find(e);
+            return found == remap.end() ? 0 : found->second;
+        };
+        
+        py::object loads = py::module_::import("pickle").attr("loads");
+        while (reader.remaining()) {
+            uint8_t op;
+            ecs_entity_t entity = 0;
+            ecs_id_t id = 0;
+            Definition definition;
+            std::string text;
+            int64_t frame_number = 0;
+            bool enabled = false;
+            
+            // Read the whole record before applying it
+            try {
+                op = reader.value<uint8_t>();
+                if (op == JournalDefine) {
+                    definition = read_definition(reader);
+                } else if (op == JournalFrame) {
+                    frame_number = reader.value<int64_t>();
+                } else {
+                    entity = reader.value<uint64_t>();
+                }
+                if (op == JournalAdd || op == JournalRemove || op == JournalSetNative || op == JournalSetPython ||
+                    op == JournalToggle) {
+                    id = read_mapped_id(reader, remap);
+                }
+                if (op == JournalToggle) {
+                    enabled = reader.value<uint8_t>() != 0;
+                }
+                if (op == JournalSetNative || op == JournalSetPython || op == JournalName) {
+                    text = reader.string();
+                }
+            } catch (const std::runtime_error&) {
+                break;
+            }
+            
+            if (op == JournalFrame) {
+                if (until_frame >= 0 && frame_number >= until_frame) {
+                    break;
+                }
+                continue;
+            }
+            
+            if (op == JournalDefine) {
+                define_entity(definition, remap);
+                continue;
+            }
+            
+            ecs_entity_t e = map_entity(entity);
+            if (!e || (!id && op != JournalName && op != JournalDelete)) {
+                continue;
+            }
+            
+            if (op == JournalAdd) {
+                ecs_add_id(world, e, id);
+            } else if (op == JournalRemove) {
+                store_erase(world, e, id);
+                ecs_remove_id(world, e, id);
+            } else if (op == JournalSetNative) {
+                const ecs_type_info_t* type_info = ecs_get_type_info(world, id);
+                if (type_info && static_cast<size_t>(type_info->size) == text.size()) {
+                    ecs_set_id(world, e, id, text.size(), text.data());
+                }
+            } else if (op == JournalSetPython) {
+                py::object obj = loads(py::bytes(text));
+                store_set(world, e, id, obj);
+                PyComponentRef ref = { obj.ptr() };
+                ecs_set_id(world, e, id, sizeof(PyComponentRef), &ref);
+            } else if (op == JournalToggle) {
+                if (ecs_has_id(world, e, id)) {
+                    ecs_enable_id(world, e, id, enabled);
+                }
+            } else if (op == JournalName) {
+                ecs_set_name(world, e, text.empty() ? nullptr : text.c_str());
+            } else if (op == JournalDelete) {
+                ecs_delete(world, e);
+                remap.erase(entity);
+            }
+        }
+    }
+
+    // Encode what changed since a version returned by an earlier diff (0 for the
+    // whole world) for apply_delta on a mirror. Returns (delta, version).
+    py::tuple diff(uint64_t since_version = 0) {
+        if (!delta_tracker) {
+            delta_tracker = std::make_unique<DeltaTracker>();
+            ecs_id_t observed[3] = {EcsWildcard, ecs_pair(EcsWildcard, EcsWildcard), ecs_pair(ecs_id(EcsIdentifier), EcsName)};
+            for (ecs_id_t id : observed) {
+                ecs_observer_desc_t desc = {};
+                desc.query.terms[0].id = id;
+                desc.query.flags = EcsQueryMatchPrefab | EcsQueryMatchDisabled;
+                if (id == observed[2]) {
+                    desc.events[0] = EcsOnSet;
+                } else {
+                    desc.events[0] = EcsOnAdd;
+                    desc.events[1] = EcsOnRemove;
+                }
+                desc.callback = DeltaObserver;
+                desc.ctx = delta_tracker.get();
+                ecs_observer_init(world, &desc);
+            }
+            state->delta = delta_tracker.get();
+        }
+        
+        DeltaTracker& tracker = *delta_tracker;
+        if (since_version > tracker.version) {
+            throw std::runtime_error("Unknown world version: " + std::to_string(since_version));
+        }
+        if (since_version && since_version < tracker.log_floor) {
+            throw std::runtime_error("Changes since version " + std::to_string(since_version) +
+                " are no longer available, use diff(0) for the whole world");
+        }
+        uint64_t to_version = ++tracker.version;
+        
+        struct IdChange {
+            ecs_entity_t entity;
+            ecs_id_t id;
+            bool added;
+        };
+        std::vector<ecs_entity_t> entities;
+        std::vector<IdChange> changes;
+        // Enable state of CanToggle ids, added is whether the id is enabled
+        std::vector<IdChange> toggles;
+        std::set<ecs_entity_t> referenced;
+        // Elements of pairs with a deleted target are 0
+        auto reference = [&](ecs_id_t id) {
+            ecs_entity_t elements[2] = {id, 0};
+            if (ECS_IS_PAIR(id)) {
+                elements[0] = ecs_pair_first(world, id);
+                elements[1] = ecs_pair_second(world, id);
+            }
+            for (ecs_entity_t e : elements) {
+                if (e && ecs_is_alive(world, e)) {
+                    referenced.insert(e);
+                }
+            }
+        };
+        
+        if (since_version == 0) {
+            std::vector<ecs_entity_t> non_fragmenting = non_fragmenting_ids(world);
+            flecs::query<> entity_query = user_entity_query();
+            ecs_iter_t it = ecs_query_iter(world, entity_query.c_ptr());
+            while (ecs_query_next(&it)) {
+                const ecs_type_t* type = ecs_table_get_type(it.table);
+                for (int i = 0; i < it.count; i++) {
+                    entities.push_back(it.entities[i]);
+                    std::vector<ecs_id_t> ids(type->array, type->array + type->count);
+                    append_non_fragmenting(world, it.entities[i], non_fragmenting, ids);
+                    for (ecs_id_t id : ids) {
+                        if ((id & ECS_ID_FLAGS_MASK & ~ECS_PAIR) || is_py_component(world, id) ||
+                            (ECS_IS_PAIR(id) && ecs_pair_first(world, id) == ecs_id(EcsIdentifier))) {
+                            continue;
+                        }
+                        changes.push_back({it.entities[i], id, true});
+                    }
+                    
+                    std::vector<ecs_id_t> disabled;
+                    append_disabled_toggles(world, it.table, it.entities[i], disabled);
+                    for (ecs_id_t id : disabled) {
+                        toggles.push_back({it.entities[i], id, false});
+                    }
+                }
+            }
+        } else {
+            // Compare the state at the start and end of the range, so an id that was
+            // added and removed again is left out
+            std::set<ecs_entity_t> touched;
+            std::vector<std::pair<ecs_entity_t, ecs_id_t>> order;
+            std::map<std::pair<ecs_entity_t, ecs_id_t>, std::pair<bool, bool>> net;
+            std::set<std::pair<ecs_entity_t, ecs_id_t>> toggled;
+            auto first = std::upper_bound(tracker.log.begin(), tracker.log.end(), since_version,
+                [](uint64_t v, const DeltaTracker::Change& c) { return v < c.version; });
+            for (auto it = first; it != tracker.log.end(); ++it) {
+                if (touched.insert(it->entity).second) {
+                    entities.push_back(it->entity);
+                }
+                if (!it->id) {
+                    continue;
+                }
+                // Only the enable state at the end of the range is sent
+                if (it->toggled) {
+                    toggled.insert({it->entity, it->id});
+                    continue;
+                }
+                auto inserted = net.emplace(std::make_pair(it->entity, it->id), std::make_pair(!it->added, it->added));
+                if (inserted.second) {
+                    order.push_back({it->entity, it->id});
+                } else {
+                    inserted.first->second.second = it->added;
+                }
+            }
+            // Ids of deleted entities go with them
+            for (const auto& key : order) {
+                const std::pair<bool, bool>& m = net[key];
+                if (m.first != m.second && ecs_is_alive(world, key.first)) {
+                    changes.push_back({key.first, key.second, m.second});
+                }
+            }
+            for (const auto& key : toggled) {
+                if (ecs_is_alive(world, key.first) && ecs_has_id(world, key.first, key.second)) {
+                    toggles.push_back({key.first, key.second, ecs_is_enabled_id(world, key.first, key.second)});
+                }
+            }
+        }
+        // Storage traits are added before the ids that use them
+        std::stable_partition(changes.begin(), changes.end(), [](const IdChange& change) {
+            return is_storage_trait(change.id);
+        });
+        for (const IdChange& change : changes) {
+            reference(change.id);
+        }
+        for (const IdChange& toggle : toggles) {
+            reference(toggle.id);
+        }
+        
+        // Components are collected first, creating their queries changes tables
+        std::vector<ecs_entity_t> components;
+        std::vector<ecs_entity_t> sparse_components;
+        ecs_iter_t struct_it = ecs_each_id(world, ecs_id(EcsStruct));
+        while (ecs_each_next(&struct_it)) {
+            for (int i = 0; i < struct_it.count; i++) {
+                ecs_entity_t component = struct_it.entities[i];
+                if (is_builtin_entity(world, component) || !ecs_get_type_info(world, component)) {
+                    continue;
+                }
+                if (is_sparse_id(world, component)) {
+                    sparse_components.push_back(component);
+                } else {
+                    components.push_back(component);
+                }
+            }
+        }
+        
+        std::string columns;
+        uint32_t column_count = 0;
+        for (ecs_entity_t component : components) {
+            DeltaTracker::Column& column = tracker.columns[component];
+            if (!column.query) {
+                ecs_query_desc_t desc = {};
+                desc.terms[0].id = component;
+                desc.terms[1].id = ecs_id(EcsComponent);
+                desc.terms[1].oper = EcsNot;
+                desc.flags = EcsQueryMatchPrefab | EcsQueryMatchDisabled;
+                enable_change_detection(desc);
+                column.query = ecs_query_init(world, &desc);
+            }
+            
+            size_t size = static_cast<size_t>(ecs_get_type_info(world, component)->size);
+            std::unordered_map<ecs_table_t*, uint64_t> versions;
+            ecs_iter_t it = ecs_query_iter(world, column.query);
+            while (ecs_query_next(&it)) {
+                auto stamp = column.versions.find(it.table);
+                uint64_t table_version = stamp == column.versions.end() ? 0 : stamp->second;
+                if (ecs_iter_changed(&it)) {
+                    table_version = to_version;
+                }
+                versions[it.table] = table_version;
+                bool changed = since_version == 0 || table_version > since_version;
+                if (!changed || !it.count || !ecs_field_is_self(&it, 0)) {
+                    continue;
+                }
+                
+                record_value<uint64_t>(columns, component);
+                record_value<uint32_t>(columns, static_cast<uint32_t>(it.count));
+                record_value<uint32_t>(columns, static_cast<uint32_t>(size));
+                columns.append(reinterpret_cast<const char*>(it.entities), it.count * sizeof(ecs_entity_t));
+                columns.append(static_cast<const char*>(ecs_field_w_size(&it, size, 0)), it.count * size);
+                referenced.insert(component);
+                column_count++;
+            }
+            column.versions = std::move(versions);
+        }
+        
+        // Sparse values have no change detection, they are sent with every delta
+        for (ecs_entity_t component : sparse_components) {
+            size_t size = static_cast<size_t>(ecs_get_type_info(world, component)->size);
+            std::vector<ecs_entity_t> owners;
+            std::string values;
+            ecs_iter_t it = ecs_each_id(world, component);
+            while (ecs_each_next(&it)) {
+                for (int i = 0; i < it.count; i++) {
+                    owners.push_back(it.entities[i]);
+                    values.append(static_cast<const char*>(ecs_field_at_w_size(&it, size, 0, i)), size);
+                }
+            }
+            if (owners.empty()) {
+                continue;
+            }
+            record_value<uint64_t>(columns, component);
+            record_value<uint32_t>(columns, static_cast<uint32_t>(owners.size()));
+            record_value<uint32_t>(columns, static_cast<uint32_t>(size));
+            columns.append(reinterpret_cast<const char*>(owners.data()), owners.size() * sizeof(ecs_entity_t));
+            columns.append(values);
+            referenced.insert(component);
+            column_count++;
+        }
+        
+        std::string out;
+        out.append(DELTA_MAGIC, sizeof(DELTA_MAGIC));
+        record_value<uint32_t>(out, DELTA_VERSION);
+        record_value<uint64_t>(out, since_version);
+        record_value<uint64_t>(out, to_version);
+        
+        record_value<uint32_t>(out, static_cast<uint32_t>(referenced.size()));
+        for (ecs_entity_t e : referenced) {
+            std::vector<NativeField> fields;
+            JournalKind kind = definition_kind(world, e, fields);
+            write_definition(out, world, e, kind, fields);
+        }
+        
+        record_value<uint32_t>(out, static_cast<uint32_t>(entities.size()));
+        for (ecs_entity_t e : entities) {
+            bool alive = ecs_is_alive(world, e);
+            const char* name = alive ? ecs_get_name(world, e) : nullptr;
+            record_value<uint64_t>(out, e);
+            record_value<uint8_t>(out, alive ? 1 : 0);
+            record_string(out, name ? name : "");
+        }
+        
+        record_value<uint32_t>(out, static_cast<uint32_t>(changes.size()));
+        for (const IdChange& change : changes) {
+            record_value<uint64_t>(out, change.entity);
+            record_id(out, world, change.id);
+            record_value<uint8_t>(out, change.added ? 1 : 0);
+        }
+        
+        record_value<uint32_t>(out, static_cast<uint32_t>(toggles.size()));
+        for (const IdChange& toggle : toggles) {
+            record_value<uint64_t>(out, toggle.entity);
+            record_id(out, world, toggle.id);
+            record_value<uint8_t>(out, toggle.added ? 1 : 0);
+        }
+        
+        record_value<uint32_t>(out, column_count);
+        out.append(columns);
+        
+        return py::make_tuple(py::bytes(out), to_version);
+    }
+    
+    // Apply a delta from diff() to this world, which mirrors the world that made it.
+    // Entities are mapped to ids of this world. Returns the version of the delta.
+    uint64_t apply_delta(py::buffer delta) {
+        py::buffer_info info = delta.request();
+        ImageReader reader(static_cast<const char*>(info.ptr), static_cast<size_t>(info.size * info.itemsize));
+        if (reader.remaining() < sizeof(DELTA_MAGIC) + sizeof(uint32_t) ||
+            memcmp(reader.read(sizeof(DELTA_MAGIC)), DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0) {
+            throw std::runtime_error("Not a world delta");
+        }
+        if (reader.value<uint32_t>() != DELTA_VERSION) {
+            throw std::runtime_error("Unsupported world delta version");
+        }
+        uint64_t from_version = reader.value<uint64_t>();
+        uint64_t to_version = reader.value<uint64_t>();
+        if (from_version > delta_applied) {
+            throw std::runtime_error("Delta starts at version " + std::to_string(from_version) +
+                " but the mirror is at version " + std::to_string(delta_applied));
+        }
+        
+        auto map_entity = [&](ecs_entity_t e) -> ecs_entity_t {
+            auto found = delta_remap.find(e);
+            return found == delta_remap.end() || !ecs_is_alive(world, found->second) ? 0 : found->second;
+        };
+        
+        uint32_t definition_count = reader.value<uint32_t>();
+        for (uint32_t d = 0; d < definition_count; d++) {
+            define_entity(read_definition(reader), delta_remap);
+        }
+        
+        std::vector<std::pair<ecs_entity_t, std::string>> names;
+        uint32_t entity_count = reader.value<uint32_t>();
+        for (uint32_t i = 0; i < entity_count; i++) {
+            ecs_entity_t old_id = reader.value<uint64_t>();
+            bool alive = reader.value<uint8_t>() != 0;
+            std::string name = reader.string();
+            ecs_entity_t e = map_entity(old_id);
+            if (!alive) {
+                if (e) {
+                    ecs_delete(world, e);
+                }
+                delta_remap.erase(old_id);
+                continue;
+            }
+            if (!e) {
+                e = ecs_new(world);
+                delta_remap[old_id] = e;
+            }
+            names.push_back({e, name});
+        }
+        
+        uint32_t change_count = reader.value<uint32_t>();
+        for (uint32_t c = 0; c < change_count; c++) {
+            ecs_entity_t e = map_entity(reader.value<uint64_t>());
+            ecs_id_t id = read_mapped_id(reader, delta_remap);
+            bool added = reader.value<uint8_t>() != 0;
+            if (!e || !id) {
+                continue;
+            }
+            if (added) {
+                ecs_add_id(world, e, id);
+            } else {
+                ecs_remove_id(world, e, id);
+            }
+        }
+        
+        uint32_t toggle_count = reader.value<uint32_t>();
+        for (uint32_t t = 0; t < toggle_count; t++) {
+            ecs_entity_t e = map_entity(reader.value<uint64_t>());
+            ecs_id_t id = read_mapped_id(reader, delta_remap);
+            bool enabled = reader.value<uint8_t>() != 0;
+            if (e && id && ecs_has_id(world, e, id)) {
+                ecs_enable_id(world, e, id, enabled);
+            }
+        }
+        
+        std::vector<char> value;
+        uint32_t column_count = reader.value<uint32_t>();
+        for (uint32_t c = 0; c < column_count; c++) {
+            ecs_entity_t component = map_entity(reader.value<uint64_t>());
+            uint32_t count = reader.value<uint32_t>();
+            size_t size = reader.value<uint32_t>();
+            const char* old_entities = reader.read(count * sizeof(ecs_entity_t));
+            const char* data = reader.read(count * size);
+            const ecs_type_info_t* type_info = component ? ecs_get_type_info(world, component) : nullptr;
+            if (!type_info || static_cast<size_t>(type_info->size) != size) {
+                continue;
+            }
+            
+            // Entity fields hold ids of the other world
+            std::vector<NativeField> entity_fields;
+            for (const NativeField& field : native_fields(world, component)) {
+                if (field.type == ecs_id(ecs_entity_t)) {
+                    entity_fields.push_back(field);
+                }
+            }
+            
+            value.resize(size);
+            for (uint32_t row = 0; row < count; row++) {
+                ecs_entity_t old_id;
+                memcpy(&old_id, old_entities + row * sizeof(ecs_entity_t), sizeof(ecs_entity_t));
+                ecs_entity_t e = map_entity(old_id);
+                if (!e) {
+                    continue;
+                }
+                memcpy(value.data(), data + row * size, size);
+                for (const NativeField& field : entity_fields) {
+                    ecs_entity_t target;
+                    memcpy(&target, value.data() + field.offset, sizeof(ecs_entity_t));
+                    target = target ? map_entity(target) : 0;
+                    memcpy(value.data() + field.offset, &target, sizeof(ecs_entity_t));
+                }
+                ecs_set_id(world, e, component, size, value.data());
+            }
         }
         
-        std::vector<QueryTerm> query_terms;
-        std::vector<std::string> var_names;
-        ecs_query_desc_t query_desc = generate_query_from_args(args, world, var_names, query_terms);
-        // ecs_query_t* query = ecs_query_init(world, &query_desc);
-        desc.query = query_desc;
+        // Names are set last, once entities are in their parent's scope
+        for (const auto& [e, name] : names) {
+            const char* current = ecs_get_name(world, e);
+            if (name != (current ? current : "")) {
+                ecs_set_name(world, e, name.empty() ? nullptr : name.c_str());
+            }
+        }
+        
+        delta_applied = to_version;
+        return to_version;
+    }
 
-        PyQueryIterator py_query = PyQueryIterator(world, query_desc, var_names, query_terms);
-        observer_queries.push_back(py_query);
+    // Create a custom pipeline phase that runs after depends_on
+    PyEntity phase(const std::string& name, py::object depends_on = py::none()) {
+        ecs_entity_t phase_entity = world.entity(name.c_str()).id();
+        ecs_entity_t dependency = depends_on.is_none() ? EcsOnUpdate : entity_from_object(world, depends_on);
+        ecs_add_id(world, phase_entity, EcsPhase);
+        ecs_add_pair(world, phase_entity, EcsDependsOn, dependency);
+        return PyEntity(flecs::entity(world, phase_entity));
+    }
 
-        ecs_observer_init(world, &desc);
+    // Create a timer that ticks every interval seconds, usable as a tick_source
+    PyEntity timer(float interval) {
+        ecs_entity_t timer_entity = ecs_set_interval(world, 0, interval);
+        return PyEntity(flecs::entity(world, timer_entity));
     }
 
-    void create_system(py::function callback, py::args component_types) {
+    // Create a rate filter that ticks once every rate ticks of its source (or frames)
+    PyEntity rate_filter(int32_t rate, py::object source = py::none()) {
+        ecs_entity_t source_entity = source.is_none() ? 0 : entity_from_object(world, source);
+        ecs_entity_t filter_entity = ecs_set_rate(world, 0, rate, source_entity);
+        return PyEntity(flecs::entity(world, filter_entity));
+    }
+
+    PyEntity create_system(py::function callback, py::args component_types, bool changed_only = false, bool track_writes = false,
+        const SystemSchedule& schedule = SystemSchedule(), ecs_entity_t cascade = 0)
+    {
         py::print("Creating system with", component_types.size(), "components");
         
-        // Store the callback
-        size_t callback_index = system_callbacks.size();
-        system_callbacks.push_back(callback);
-        
         // Parse component types
         std::vector<ecs_entity_t> component_ids;
         for (auto arg : component_types) {
             py::object comp_type = arg.cast<py::object>();
             std::string component_name = py::str(comp_type.attr("__name__"));
             py::print("  Component:", component_name);
-            ecs_entity_t component_id = world.entity(component_name.c_str()).id();
+            ecs_entity_t component_id = py_component_entity(world, comp_type).id();
             component_ids.push_back(component_id);
         }
         
-        // CRITICAL FIX: Create the system entity first with proper phase setup
-        ecs_entity_t system_entity = ecs_new(world);
-        ecs_add_pair(world, system_entity, EcsDependsOn, EcsOnUpdate);
-        ecs_add_id(world, system_entity, EcsOnUpdate);
+        // Store the callback. Every term is a Python component, the cascade term adds
+        // the component of the parent.
+        size_t callback_index;
+        {
+            BindingStateLock lock(*state);
+            callback_index = state->system_callbacks.size();
+            state->system_callbacks.push_back(callback);
+            state->system_changed_only.push_back(changed_only);
+            state->system_track_writes.push_back(track_writes);
+            state->system_arities.push_back(1 + component_ids.size() + (cascade && !component_ids.empty() ? 1 : 0));
+        }
         
+        // CRITICAL FIX: Create the system entity first with proper phase setup
         ecs_system_desc_t desc = {};
-        desc.entity = system_entity;  // Assign the pre-created entity
+        ecs_entity_t system_entity = init_system_entity(world, desc, schedule);
         desc.callback = PythonSystemCallback;
         desc.ctx = reinterpret_cast<void*>(callback_index);
         
@@ -1388,24 +6885,33 @@ public:
                 .oper = EcsAnd
             };
         }
+        if (cascade && !component_ids.empty()) {
+            add_cascade_term(desc.query, component_ids.size(), component_ids[0], cascade);
+        }
+        if (changed_only) {
+            enable_change_detection(desc.query);
+        }
         
         // Initialize the system with the pre-configured entity
         ecs_entity_t result = ecs_system_init(world, &desc);
         if (result == 0) {
             py::print("ERROR: Failed to create system!");
-            return;
         }
+        return PyEntity(flecs::entity(world, system_entity));
     }
 
     void create_observer_iter(py::function callback, py::args component_types, py::list events = py::list()) {
-        size_t callback_index = observer_iter_callbacks.size();
-        observer_iter_callbacks.push_back(callback);
+        size_t callback_index;
+        {
+            BindingStateLock lock(*state);
+            callback_index = state->observer_iter_callbacks.size();
+            state->observer_iter_callbacks.push_back(callback);
+        }
         
         std::vector<ecs_entity_t> component_ids;
         for (auto arg : component_types) {
             py::object comp_type = arg.cast<py::object>();
-            std::string component_name = py::str(comp_type.attr("__name__"));
-            ecs_entity_t component_id = world.entity(component_name.c_str()).id();
+            ecs_entity_t component_id = py_component_entity(world, comp_type).id();
             component_ids.push_back(component_id);
         }
         
@@ -1415,8 +6921,7 @@ public:
             event_list.push_back(EcsOnAdd);  // Default event
         } else {
             for (auto event : events) {
-                ecs_entity_t event_id = event.cast<ecs_entity_t>();
-                event_list.push_back(event_id);
+                event_list.push_back(entity_from_object(world, event));
             }
         }
         
@@ -1439,24 +6944,26 @@ public:
     }
     
     // Create iterator-based system
-    void create_system_iter(py::function callback, py::args component_types) {
-        size_t callback_index = system_iter_callbacks.size();
-        system_iter_callbacks.push_back(callback);
+    PyEntity create_system_iter(py::function callback, py::args component_types, bool changed_only = false,
+        const SystemSchedule& schedule = SystemSchedule(), ecs_entity_t cascade = 0)
+    {
+        size_t callback_index;
+        {
+            BindingStateLock lock(*state);
+            callback_index = state->system_iter_callbacks.size();
+            state->system_iter_callbacks.push_back(callback);
+            state->system_iter_changed_only.push_back(changed_only);
+        }
         
         std::vector<ecs_entity_t> component_ids;
         for (auto arg : component_types) {
             py::object comp_type = arg.cast<py::object>();
-            std::string component_name = py::str(comp_type.attr("__name__"));
-            ecs_entity_t component_id = world.entity(component_name.c_str()).id();
+            ecs_entity_t component_id = py_component_entity(world, comp_type).id();
             component_ids.push_back(component_id);
         }
         
-        ecs_entity_t system_entity = ecs_new(world);
-        ecs_add_pair(world, system_entity, EcsDependsOn, EcsOnUpdate);
-        ecs_add_id(world, system_entity, EcsOnUpdate);
-        
         ecs_system_desc_t desc = {};
-        desc.entity = system_entity;
+        ecs_entity_t system_entity = init_system_entity(world, desc, schedule);
         desc.callback = PythonSystemIterCallback;
         desc.ctx = reinterpret_cast<void*>(callback_index);
         
@@ -1467,21 +6974,107 @@ public:
                 .oper = EcsAnd
             };
         }
+        if (cascade && !component_ids.empty()) {
+            add_cascade_term(desc.query, component_ids.size(), component_ids[0], cascade);
+        }
+        if (changed_only) {
+            enable_change_detection(desc.query);
+        }
+        
+        ecs_system_init(world, &desc);
+        return PyEntity(flecs::entity(world, system_entity));
+    }
+
+    // Create a system that calls Python once per frame with the stacked input of all matched entities.
+    // Native components (by name) are gathered as float32 rows, or float64 when a field isn't f32.
+    // Python components must be array-like.
+    PyEntity create_system_batch(py::function callback, py::object input, py::object output, py::args filters,
+        const std::string& input_field = "", const std::string& output_field = "",
+        const SystemSchedule& schedule = SystemSchedule())
+    {
+        SystemBatchSpec spec;
+        spec.input = entity_from_object(world, input);
+        spec.output = entity_from_object(world, output);
+        spec.input_field = input_field;
+        spec.output_field = output_field;
+        if (py::isinstance<py::str>(input)) {
+            spec.input_native = native_fields(world, spec.input);
+            if (spec.input_native.empty()) {
+                throw std::runtime_error("Batch input is not a native component: " + input.cast<std::string>());
+            }
+        }
+        if (py::isinstance<py::str>(output)) {
+            spec.output_native = native_fields(world, spec.output);
+            if (spec.output_native.empty()) {
+                throw std::runtime_error("Batch output is not a native component: " + output.cast<std::string>());
+            }
+        }
+        // Tags and plain entities have no type info, and non-native terms are read as Python components
+        for (ecs_entity_t term : {spec.input, spec.output}) {
+            const ecs_type_info_t* type_info = ecs_get_type_info(world, term);
+            bool native = term == spec.input ? !spec.input_native.empty() : !spec.output_native.empty();
+            if (!type_info || (!native && !is_py_component(world, term))) {
+                char* term_name = ecs_get_path(world, term);
+                std::string message = std::string("Batch ") + (term == spec.input ? "input" : "output") +
+                    " is not a native or Python component: " + (term_name ? term_name : std::to_string(term));
+                ecs_os_free(term_name);
+                throw std::runtime_error(message);
+            }
+        }
+        spec.input_size = ecs_get_type_info(world, spec.input)->size;
+        spec.output_size = ecs_get_type_info(world, spec.output)->size;
+        spec.input_f32 = std::all_of(spec.input_native.begin(), spec.input_native.end(), [](const NativeField& field) {
+            return field.type == ecs_id(ecs_f32_t);
+        });
+        
+        size_t callback_index;
+        {
+            BindingStateLock lock(*state);
+            callback_index = state->system_batch_callbacks.size();
+            state->system_batch_callbacks.push_back(callback);
+            state->system_batch_specs.push_back(spec);
+        }
+        
+        ecs_system_desc_t desc = {};
+        ecs_entity_t system_entity = init_system_entity(world, desc, schedule);
+        desc.run = PythonSystemBatchRun;
+        desc.ctx = reinterpret_cast<void*>(callback_index);
+        
+        desc.query.terms[0] = { .id = spec.input, .inout = EcsIn };
+        desc.query.terms[1] = { .id = spec.output, .inout = EcsOut };
+        size_t term_count = 2;
+        for (auto arg : filters) {
+            if (term_count >= 32) {
+                throw std::runtime_error("Too many terms for batch system");
+            }
+            desc.query.terms[term_count++] = { .id = entity_from_object(world, arg), .inout = EcsInOutNone };
+        }
         
         ecs_system_init(world, &desc);
+        return PyEntity(flecs::entity(world, system_entity));
     }
         
     // Convenience method for decorator support
-    py::function observer_decorator(py::args component_types, py::list events = py::list()) {
-        return py::cpp_function([this, component_types, events](py::function callback) {
-            this->create_observer(callback, component_types, events);
+    py::function observer_decorator(py::args component_types, py::list events = py::list(), bool batch = false) {
+        return py::cpp_function([this, component_types, events, batch](py::function callback) {
+            this->create_observer(callback, component_types, events, batch);
             return callback;
         });
     }
 
-    py::function system_decorator(py::args component_types) {
-        return py::cpp_function([this, component_types](py::function callback) {
-            this->create_system(callback, component_types);
+    py::function system_decorator(py::args component_types, bool changed_only = false, bool track_writes = false,
+        py::object phase = py::none(), float interval = 0.0f, int32_t rate = 0, py::object tick_source = py::none(),
+        py::object cascade = py::none(), bool multi_threaded = false)
+    {
+        SystemSchedule schedule = system_schedule(phase, interval, rate, tick_source);
+        schedule.multi_threaded = multi_threaded;
+        ecs_entity_t cascade_relation = cascade_relation_id(cascade);
+        return py::cpp_function([this, component_types, changed_only, track_writes, schedule, cascade_relation](py::function callback) {
+            PyEntity system = this->create_system(callback, component_types, changed_only, track_writes, schedule, cascade_relation);
+            // Expose the system entity so it can be enabled/disabled at runtime
+            if (py::hasattr(callback, "__dict__")) {
+                callback.attr("system") = system;
+            }
             return callback;
         });
     }
@@ -1493,9 +7086,32 @@ public:
         });
     }
     
-    py::function system_iter_decorator(py::args component_types) {
-        return py::cpp_function([this, component_types](py::function callback) {
-            this->create_system_iter(callback, component_types);
+    py::function system_iter_decorator(py::args component_types, bool changed_only = false,
+        py::object phase = py::none(), float interval = 0.0f, int32_t rate = 0, py::object tick_source = py::none(),
+        py::object cascade = py::none(), bool multi_threaded = false)
+    {
+        SystemSchedule schedule = system_schedule(phase, interval, rate, tick_source);
+        schedule.multi_threaded = multi_threaded;
+        ecs_entity_t cascade_relation = cascade_relation_id(cascade);
+        return py::cpp_function([this, component_types, changed_only, schedule, cascade_relation](py::function callback) {
+            PyEntity system = this->create_system_iter(callback, component_types, changed_only, schedule, cascade_relation);
+            if (py::hasattr(callback, "__dict__")) {
+                callback.attr("system") = system;
+            }
+            return callback;
+        });
+    }
+
+    py::function system_batch_decorator(py::object input, py::object output, py::args filters,
+        const std::string& input_field = "", const std::string& output_field = "",
+        py::object phase = py::none(), float interval = 0.0f, int32_t rate = 0, py::object tick_source = py::none())
+    {
+        SystemSchedule schedule = system_schedule(phase, interval, rate, tick_source);
+        return py::cpp_function([this, input, output, filters, input_field, output_field, schedule](py::function callback) {
+            PyEntity system = this->create_system_batch(callback, input, output, filters, input_field, output_field, schedule);
+            if (py::hasattr(callback, "__dict__")) {
+                callback.attr("system") = system;
+            }
             return callback;
         });
     }
@@ -1506,9 +7122,246 @@ public:
         return PyEntity(e);
     }
     
+    // Callbacks of a frame of this world can't run another frame: progress() would
+    // re-enter the running frame and progress_async() would wait for it forever
+    void check_not_in_frame_callback() {
+        if (frame_callback_depth > 0 && (state->frames_in_progress || state->async_frames_in_flight)) {
+            throw std::runtime_error("Can't run a frame from a callback of a frame that is running");
+        }
+    }
+    
     // Progress world (run systems)
     bool progress(float delta_time = 0.0f) {
-        return world.progress(delta_time);
+        check_not_in_frame_callback();
+        bool result;
+        // Other Python threads can run while the GIL is released, the frame is
+        // counted so that they can't use the world until it is done
+        state->frames_in_progress++;
+        frames_in_any_world++;
+        {
+            TraceSpan span(TraceFrame, 0, world);
+            // Python systems on worker threads acquire the GIL themselves
+            py::gil_scoped_release release;
+            result = world.progress(delta_time);
+        }
+        state->frames_in_progress--;
+        frames_in_any_world--;
+        publish_shared();
+        if (journal) {
+            journal->frame(ecs_get_world_info(world)->frame_count_total);
+        }
+        return result;
+    }
+    
+    void publish_shared() {
+#ifndef _WIN32
+        for (auto& [name, shared] : shared_exports) {
+            publish_shared(shared);
+        }
+#endif
+    }
+    
+    // Run a frame on a native thread and return a Frame that can be awaited, polled or
+    // waited on with result(). Python callbacks of the frame run on this thread while
+    // it waits; until the frame is done the world can only be used from callbacks.
+    // A frame that is still running is waited for first.
+    PyFrame progress_async(float delta_time = 0.0f) {
+        check_not_in_frame_callback();
+        finish_async_frame();
+        
+        std::shared_ptr<AsyncFrame> frame = std::make_shared<AsyncFrame>();
+        frame->future = py::module_::import("concurrent.futures").attr("Future")();
+        std::weak_ptr<AsyncFrame> weak_frame = frame;
+        frame->pump = py::cpp_function([weak_frame] {
+            if (std::shared_ptr<AsyncFrame> f = weak_frame.lock()) {
+                f->run_pending();
+            }
+        });
+        // Frames started from a coroutine run their callbacks on its loop
+        try {
+            frame->loop = py::module_::import("asyncio").attr("get_running_loop")();
+        } catch (const py::error_already_set&) {
+        }
+        
+        async_frame = frame;
+        state->async_frames_in_flight++;
+        frames_in_any_world++;
+        frame_thread = std::thread([this, frame, delta_time]() mutable {
+            current_async_frame = frame.get();
+            bool result;
+            {
+                TraceSpan span(TraceFrame, 0, world);
+                result = world.progress(delta_time);
+            }
+            current_async_frame = nullptr;
+            
+            // The frame's Python objects are released with the GIL held
+            py::gil_scoped_acquire gil;
+            publish_shared();
+            if (journal) {
+                journal->frame(ecs_get_world_info(world)->frame_count_total);
+            }
+            {
+                std::lock_guard<std::mutex> lock(frame->mutex);
+                frame->done = true;
+                frame->result = result;
+            }
+            state->async_frames_in_flight--;
+            frames_in_any_world--;
+            frame->cv.notify_all();
+            try {
+                frame->future.attr("set_result")(result);
+            } catch (const py::error_already_set&) {
+                // The future was cancelled
+            }
+            frame.reset();
+        });
+        return PyFrame(frame);
+    }
+    
+    // Wait for the last asynchronous frame and its thread
+    void finish_async_frame() {
+        if (async_frame) {
+            async_frame->wait(-1.0);
+            async_frame.reset();
+        }
+        if (frame_thread.joinable()) {
+            py::gil_scoped_release release;
+            frame_thread.join();
+        }
+    }
+
+#ifndef _WIN32
+    // Publish native component columns (as "<Component>.entities" and "<Component>.<field>")
+    // and optionally the graph export arrays to a shared memory segment. The segment
+    // is updated after every progress() and can be read with flecs.SharedView(name).
+    void export_shared(const std::string& name, py::list components = py::list(), bool graph = false) {
+        // The old segment unlinks its name when destroyed, so it has to go first
+        auto existing = shared_exports.find(name);
+        if (existing != shared_exports.end()) {
+            if (existing->second.graph_changes) {
+                ecs_query_fini(existing->second.graph_changes);
+            }
+            shared_exports.erase(existing);
+        }
+        
+        SharedExport shared;
+        shared.graph = graph;
+        for (auto component : components) {
+            ecs_entity_t component_id = entity_from_object(world, component);
+            if (is_py_component(world, component_id) || native_fields(world, component_id).empty()) {
+                throw std::runtime_error("Only native components can be shared: " + std::string(py::str(component)));
+            }
+            shared.components.push_back(component_id);
+        }
+        if (graph) {
+            ecs_query_desc_t desc = {};
+            desc.terms[0].id = ecs_pair(EcsWildcard, EcsWildcard);
+            enable_change_detection(desc);
+            shared.graph_changes = ecs_query_init(world, &desc);
+        }
+        
+        std::vector<SharedArray> arrays = shared_layout(shared);
+        shared.segment = std::make_unique<SharedSegment>(name, std::max<size_t>(shared_slot_size(arrays) * 2, 1 << 16));
+        SharedExport& stored = shared_exports[name] = std::move(shared);
+        publish_shared(stored);
+    }
+    
+    // Rows of a shared component, counted before the columns are written into a slot
+    int64_t shared_row_count(ecs_entity_t component) {
+        int64_t count = 0;
+        ecs_iter_t it = ecs_each_id(world, component);
+        while (ecs_each_next(&it)) {
+            count += it.count;
+        }
+        return count;
+    }
+    
+    // Names, types and sizes of the arrays of an export. Graph arrays are exported
+    // again when a relationship table changed, otherwise the last ones are reused.
+    std::vector<SharedArray> shared_layout(SharedExport& shared) {
+        std::vector<SharedArray> arrays;
+        for (ecs_entity_t component : shared.components) {
+            std::string prefix = flecs::entity(world, component).name().c_str();
+            int64_t count = shared_row_count(component);
+            arrays.push_back({prefix + ".entities", "u8", {count}, static_cast<size_t>(count) * sizeof(ecs_entity_t), {}});
+            for (const NativeField& field : native_fields(world, component)) {
+                size_t field_size = static_cast<size_t>(ecs_get_type_info(world, field.type)->size);
+                arrays.push_back({prefix + "." + field.name, shared_dtype(field.type), {count},
+                    static_cast<size_t>(count) * field_size, {}});
+            }
+        }
+        
+        if (shared.graph) {
+            if (shared.graph_arrays.empty() || ecs_query_changed(shared.graph_changes)) {
+                GraphExportData data = export_graph_data();
+                int64_t num_edges = static_cast<int64_t>(data.edge_sources.size());
+                std::vector<int64_t> edge_index = data.edge_sources;
+                edge_index.insert(edge_index.end(), data.edge_targets.begin(), data.edge_targets.end());
+                shared.graph_arrays.clear();
+                shared.graph_arrays.push_back(shared_array("graph.node_ids", "i8", {static_cast<int64_t>(data.node_ids.size())}, data.node_ids));
+                shared.graph_arrays.push_back(shared_array("graph.edge_index", "i8", {2, num_edges}, edge_index));
+                shared.graph_arrays.push_back(shared_array("graph.edge_relations", "i8", {num_edges}, data.edge_relations));
+                shared.graph_arrays.push_back(shared_array("graph.edge_attr", "f4",
+                    {num_edges, static_cast<int64_t>(data.edge_attr_names.size())}, data.edge_attr));
+                
+                // Iterating the query takes the current state as the new baseline
+                ecs_iter_t it = ecs_query_iter(world, shared.graph_changes);
+                while (ecs_query_next(&it)) {
+                }
+            }
+            for (const SharedArray& array : shared.graph_arrays) {
+                arrays.push_back({array.name, array.dtype, array.shape, array.size, {}});
+            }
+        }
+        return arrays;
+    }
+    
+    // Write the component columns and graph arrays of an export straight into the free slot
+    void publish_shared(SharedExport& shared) {
+        shared.segment->publish(shared_layout(shared), [&](const std::vector<char*>& destinations) {
+            size_t index = 0;
+            for (ecs_entity_t component : shared.components) {
+                std::vector<NativeField> fields = native_fields(world, component);
+                size_t component_size = static_cast<size_t>(ecs_get_type_info(world, component)->size);
+                std::vector<size_t> field_sizes;
+                for (const NativeField& field : fields) {
+                    field_sizes.push_back(static_cast<size_t>(ecs_get_type_info(world, field.type)->size));
+                }
+                char* entity_out = destinations[index];
+                char* const* field_out = destinations.data() + index + 1;
+                index += 1 + fields.size();
+                
+                bool sparse = is_sparse_id(world, component);
+                size_t row = 0;
+                ecs_iter_t it = ecs_each_id(world, component);
+                while (ecs_each_next(&it)) {
+                    memcpy(entity_out + row * sizeof(ecs_entity_t), it.entities, it.count * sizeof(ecs_entity_t));
+                    const char* column = sparse ? nullptr : static_cast<const char*>(ecs_field_w_size(&it, component_size, 0));
+                    for (int i = 0; i < it.count; i++) {
+                        const char* ptr = sparse ? static_cast<const char*>(ecs_field_at_w_size(&it, component_size, 0, i)) :
+                            column + i * component_size;
+                        for (size_t f = 0; f < fields.size(); f++) {
+                            memcpy(field_out[f] + (row + i) * field_sizes[f], ptr + fields[f].offset, field_sizes[f]);
+                        }
+                    }
+                    row += static_cast<size_t>(it.count);
+                }
+            }
+            for (const SharedArray& array : shared.graph_arrays) {
+                if (array.size) {
+                    memcpy(destinations[index], array.data.data(), array.size);
+                }
+                index++;
+            }
+        });
+    }
+#endif
+    
+    // Worker threads for multi_threaded systems. Each worker iterates through its own
+    // stage, so entity operations from Python systems on workers are deferred and merged.
+    void set_threads(int32_t threads) {
+        ecs_set_threads(world, threads);
     }
     
     // Get info about the world
@@ -1516,6 +7369,57 @@ public:
         return "Flecs World";
     }
     
+    // Bitmap of the entities that have a tag, kept up to date as the tag is added and removed
+    PyTagSet tag_set(py::object tag) {
+        ecs_entity_t tag_id = entity_from_object(world, tag);
+        std::shared_ptr<TagBitmap>& bitmap = tag_sets[tag_id];
+        if (!bitmap) {
+            // Only entities that have the tag themselves, the observer doesn't follow IsA.
+            // ecs_each_id includes prefabs and disabled entities, so the observer matches them too.
+            bitmap = std::make_shared<TagBitmap>();
+            ecs_iter_t it = ecs_each_id(world, tag_id);
+            while (ecs_each_next(&it)) {
+                for (int i = 0; i < it.count; i++) {
+                    bitmap->insert(it.entities[i]);
+                }
+            }
+            
+            ecs_observer_desc_t desc = {};
+            desc.query.terms[0].id = tag_id;
+            desc.query.terms[0].src.id = EcsSelf;
+            desc.query.flags = EcsQueryMatchPrefab | EcsQueryMatchDisabled;
+            desc.events[0] = EcsOnAdd;
+            desc.events[1] = EcsOnRemove;
+            desc.callback = TagBitmapObserver;
+            desc.ctx = bitmap.get();
+            ecs_observer_init(world, &desc);
+        }
+        return PyTagSet(state, world, bitmap);
+    }
+    
+    // Materialized view of the entities matching the terms. A monitor observer
+    // reports when an entity starts or stops matching all terms, including for
+    // tables created later, and yield_existing fills the view with current matches.
+    PyView view(py::args args) {
+        std::shared_ptr<QueryView> view = std::make_shared<QueryView>();
+        
+        std::vector<QueryTerm> query_terms;
+        std::vector<std::string> var_names;
+        ecs_observer_desc_t desc = {};
+        desc.query = generate_query_from_args(args, world, var_names, query_terms);
+        desc.events[0] = EcsMonitor;
+        desc.yield_existing = true;
+        desc.callback = QueryViewObserver;
+        // The observer shares the view, so it stays valid during world cleanup
+        desc.ctx = new std::shared_ptr<QueryView>(view);
+        desc.ctx_free = [](void* ctx) {
+            delete static_cast<std::shared_ptr<QueryView>*>(ctx);
+        };
+        ecs_entity_t observer = ecs_observer_init(world, &desc);
+        
+        return PyView(view, std::make_shared<ObserverHandle>(state, world, observer));
+    }
+    
     // Find entities with a tag
     std::vector<PyEntity> find_with_tag(const std::string& tag_name) {
         std::vector<PyEntity> entities;
@@ -1551,20 +7455,25 @@ public:
     }
 
     // Create a query for a specific component type
-    PyQueryIterator query(py::args args) {
-        return PyQueryIterator(world, args);
+    PyQueryIterator query(py::args args, bool changed_only = false, py::object group_by = py::none(),
+        py::object order_by = py::none(), bool memoize = false, py::object where = py::none())
+    {
+        return PyQueryIterator(world, args, changed_only, group_by, order_by, memoize, where);
     }
 
     GraphExportData export_graph_data() {
+        TraceSpan span(TraceExportGraph, 0, world);
         GraphExportData data;
         
         // First, collect all entities that participate in relationships
         std::set<int64_t> entity_ids;
         std::vector<std::tuple<int64_t, int64_t, int64_t>> raw_edges; // (source, target, relation)
+        std::vector<std::vector<std::pair<size_t, float>>> raw_features; // (attribute index, value)
+        std::map<std::string, size_t> attr_index;
         
-        // Query all relationships using Flecs query API
+        // Query all relationships using Flecs query API, reading pair data for edge features
         flecs::query<> query = world.query_builder<>()
-            .with("$r").second(flecs::Wildcard)
+            .with("$r").second(flecs::Wildcard).in()
             .without(flecs::ChildOf, "flecs").self().up()
             .build();
 
@@ -1582,6 +7491,25 @@ public:
             entity_ids.insert(tgt.id());
             
             raw_edges.push_back(std::make_tuple(src.id(), tgt.id(), rel.id()));
+            
+            std::vector<std::pair<size_t, float>> features;
+            ecs_iter_t* iter = it.c_ptr();
+            ecs_id_t pair_id = ecs_field_id(iter, 0);
+            size_t size = ecs_field_size(iter, 0);
+            if (size && !is_py_component(world, pair_id)) {
+                const char* ptr;
+                if (is_sparse_id(world, pair_id)) {
+                    ptr = static_cast<const char*>(ecs_field_at_w_size(iter, size, 0, static_cast<int32_t>(index)));
+                } else {
+                    const char* column = static_cast<const char*>(ecs_field_w_size(iter, size, 0));
+                    ptr = ecs_field_is_self(iter, 0) ? column + index * size : column;
+                }
+                for (const NativeField& field : native_fields(world, ecs_get_typeid(world, pair_id))) {
+                    size_t attr = attr_index.emplace(field.name, attr_index.size()).first->second;
+                    features.push_back({attr, static_cast<float>(native_field_get(field, ptr))});
+                }
+            }
+            raw_features.push_back(std::move(features));
         });
         
         // Create node mapping
@@ -1608,6 +7536,18 @@ public:
             data.relation_names.push_back(rel_name ? std::string(rel_name) : std::to_string(rel_id));
         }
         
+        // Edges of relations without a field are zero for that attribute
+        data.edge_attr_names.resize(attr_index.size());
+        for (const auto& [name, attr] : attr_index) {
+            data.edge_attr_names[attr] = name;
+        }
+        data.edge_attr.assign(raw_edges.size() * attr_index.size(), 0.0f);
+        for (size_t edge = 0; edge < raw_features.size(); edge++) {
+            for (const auto& [attr, value] : raw_features[edge]) {
+                data.edge_attr[edge * attr_index.size() + attr] = value;
+            }
+        }
+        
         return data;
     }
 
@@ -1624,6 +7564,8 @@ public:
             result["edge_index"] = py::array_t<int64_t>(std::vector<py::ssize_t>{2, 0});
             result["edge_relations"] = py::array_t<int64_t>(0);
             result["relation_names"] = py::list();
+            result["edge_attr"] = py::array_t<float>(std::vector<py::ssize_t>{0, 0});
+            result["edge_attr_names"] = py::list();
             result["num_nodes"] = 0;
             result["num_edges"] = 0;
             return result;
@@ -1679,15 +7621,405 @@ public:
             result["relation_names"] = py::list();
         }
         
+        // Edge features as a num_edges x num_attributes float32 array
+        result["edge_attr"] = py::array_t<float>(
+            std::vector<py::ssize_t>{static_cast<py::ssize_t>(data.edge_sources.size()),
+                                     static_cast<py::ssize_t>(data.edge_attr_names.size())},
+            data.edge_attr.data()
+        );
+        py::list edge_attr_names_list;
+        for (const std::string& name : data.edge_attr_names) {
+            edge_attr_names_list.append(name);
+        }
+        result["edge_attr_names"] = edge_attr_names_list;
+        
         result["num_nodes"] = static_cast<int>(data.node_ids.size());
         result["num_edges"] = static_cast<int>(data.edge_sources.size());
         
         return result;
     }
 
+    // Serve the world over HTTP with the flecs REST and stats addons, e.g. for the
+    // flecs explorer. The server accepts connections on its own thread and queues
+    // requests, which are answered during progress() so they see a consistent world.
+    // WorldMetrics is sampled every sample_interval seconds; per-system timings
+    // cost a clock read per system run and are off unless system_timings is set.
+    void enable_rest(uint16_t port = 27750, const std::string& bind = "127.0.0.1", float sample_interval = 1.0f,
+        bool system_timings = false)
+    {
+        if (sample_interval < 0) {
+            throw std::runtime_error("sample_interval must not be negative");
+        }
+        ecs_import_c(world, FlecsRestImport, "FlecsRest");
+        ecs_import_c(world, FlecsStatsImport, "FlecsStats");
+        ecs_measure_frame_time(world, true);
+        ecs_measure_system_time(world, system_timings);
+        
+        if (!rest_sampler) {
+            rest_sampler = std::make_unique<RestSampler>();
+            py::dict fields;
+            for (const char* name : {"entities", "tables", "tables_created", "tables_deleted", "frames"}) {
+                fields[name] = "i64";
+            }
+            for (const char* name : {"frame_time", "system_time", "sample_time"}) {
+                fields[name] = "f64";
+            }
+            rest_sampler->component = init_native_component(world, "WorldMetrics", fields).id();
+            rest_sampler->last = *ecs_get_world_info(world);
+            
+            SystemSchedule schedule;
+            schedule.phase = EcsPostFrame;
+            schedule.interval = sample_interval;
+            ecs_system_desc_t desc = {};
+            rest_sampler->system = init_system_entity(world, desc, schedule);
+            desc.callback = RestSampleRun;
+            desc.ctx = rest_sampler.get();
+            ecs_system_init(world, &desc);
+        } else {
+            ecs_set_interval(world, rest_sampler->system, sample_interval);
+        }
+        
+        rest_bind = bind;
+        EcsRest rest = {};
+        rest.port = port;
+        rest.ipaddr = const_cast<char*>(rest_bind.c_str());
+        ecs_set_ptr(world, EcsWorld, EcsRest, &rest);
+    }
+    
+    // Break down memory use by archetype, component, bookkeeping and Python objects.
+    // Storage is computed from table capacities and element sizes, id record and entity
+    // index overhead are estimates and flagged with "estimated". Python objects of this
+    // world are measured with sys.getsizeof unless a sizer is passed, python=False skips
+    // them for cheap periodic sampling.
+    py::dict memory_report(bool python = true, py::object sizer = py::none()) {
+        py::dict report;
+        size_t total = 0;
+        
+        flecs::query<> table_query = world.query_builder<>()
+            .with(flecs::Any)
+            .query_flags(EcsQueryMatchPrefab | EcsQueryMatchDisabled | EcsQueryMatchEmptyTables)
+            .build();
+        
+        struct ArchetypeMemory {
+            ecs_table_t* table;
+            int32_t count;
+            int32_t capacity;
+            size_t bytes;
+        };
+        std::vector<ArchetypeMemory> archetypes;
+        std::map<ecs_id_t, size_t> component_bytes;
+        size_t table_bytes = 0;
+        
+        ecs_iter_t it = ecs_query_iter(world, table_query.c_ptr());
+        while (ecs_query_next(&it)) {
+            ecs_table_t* table = it.table;
+            int32_t capacity = ecs_table_size(table);
+            size_t bytes = static_cast<size_t>(capacity) * sizeof(ecs_entity_t);
+            const ecs_type_t* type = ecs_table_get_type(table);
+            for (int32_t i = 0; i < type->count; i++) {
+                int32_t column = ecs_table_type_to_column_index(table, i);
+                if (column == -1) {
+                    continue;
+                }
+                size_t column_bytes = static_cast<size_t>(capacity) * ecs_table_get_column_size(table, column);
+                component_bytes[type->array[i]] += column_bytes;
+                bytes += column_bytes;
+            }
+            archetypes.push_back({table, ecs_table_count(table), capacity, bytes});
+            table_bytes += bytes;
+        }
+        
+        std::sort(archetypes.begin(), archetypes.end(), [](const ArchetypeMemory& a, const ArchetypeMemory& b) {
+            return a.bytes > b.bytes;
+        });
+        py::list archetype_list;
+        for (const ArchetypeMemory& archetype : archetypes) {
+            char* type_str = ecs_table_str(world, archetype.table);
+            py::dict entry;
+            entry["type"] = type_str ? std::string(type_str) : std::string();
+            entry["count"] = archetype.count;
+            entry["capacity"] = archetype.capacity;
+            entry["bytes"] = archetype.bytes;
+            archetype_list.append(entry);
+            ecs_os_free(type_str);
+        }
+        
+        py::dict components;
+        for (const auto& [id, bytes] : component_bytes) {
+            components[py::str(flecs::id(world, id).str().c_str())] = bytes;
+        }
+        
+        py::dict tables;
+        tables["count"] = archetypes.size();
+        tables["bytes"] = table_bytes;
+        report["tables"] = tables;
+        report["archetypes"] = archetype_list;
+        report["components"] = components;
+        total += table_bytes;
+        
+        // Each id used in the world has a record with per table caches. flecs doesn't
+        // report their size, this assumes roughly 256 bytes per record.
+        const ecs_world_info_t* info = ecs_get_world_info(world);
+        size_t id_count = static_cast<size_t>(info->tag_id_count + info->component_id_count + info->pair_id_count);
+        size_t id_record_bytes = id_count * 256;
+        py::dict id_records;
+        id_records["count"] = id_count;
+        id_records["bytes"] = id_record_bytes;
+        id_records["estimated"] = true;
+        report["id_records"] = id_records;
+        total += id_record_bytes;
+        
+        // Dense and sparse entries plus the record of every entity
+        ecs_entities_t entities = ecs_get_entities(world);
+        size_t index_bytes = static_cast<size_t>(entities.count) * (sizeof(ecs_record_t) + 2 * sizeof(uint64_t));
+        py::dict entity_index;
+        entity_index["alive"] = entities.alive_count;
+        entity_index["bytes"] = index_bytes;
+        entity_index["estimated"] = true;
+        report["entity_index"] = entity_index;
+        total += index_bytes;
+        
+        // Name strings, the EcsIdentifier columns are part of the table memory
+        size_t name_count = 0;
+        size_t name_bytes = 0;
+        ecs_iter_t name_it = ecs_each_pair(world, ecs_id(EcsIdentifier), EcsName);
+        while (ecs_each_next(&name_it)) {
+            const EcsIdentifier* names = static_cast<const EcsIdentifier*>(ecs_field_w_size(&name_it, sizeof(EcsIdentifier), 0));
+            for (int i = 0; i < name_it.count; i++) {
+                name_bytes += names[i].value ? static_cast<size_t>(names[i].length) + 1 : 0;
+            }
+            name_count += static_cast<size_t>(name_it.count);
+        }
+        py::dict name_storage;
+        name_storage["count"] = name_count;
+        name_storage["bytes"] = name_bytes;
+        report["names"] = name_storage;
+        total += name_bytes;
+        
+        // Python objects of this world by component, relationship pairs are reported by relation
+        py::dict python_objects;
+        if (python) {
+            py::object size_of = sizer.is_none() ? py::module_::import("sys").attr("getsizeof") : sizer;
+            std::vector<std::pair<ecs_entity_t, py::object>> objects;
+            {
+                BindingStateLock lock(*state);
+                for (const auto& [entity_id, entity_objects] : state->component_objects) {
+                    for (const auto& [id, obj] : entity_objects) {
+                        objects.push_back({ECS_IS_PAIR(id) ? ecs_pair_first(world, id) : id, obj});
+                    }
+                }
+            }
+            std::map<ecs_entity_t, std::pair<size_t, size_t>> by_component;
+            for (const auto& [component, obj] : objects) {
+                std::pair<size_t, size_t>& usage = by_component[component];
+                usage.first++;
+                usage.second += size_of(obj).cast<size_t>();
+            }
+            for (const auto& [component, usage] : by_component) {
+                py::dict entry;
+                entry["count"] = usage.first;
+                entry["bytes"] = usage.second;
+                python_objects[py::str(flecs::entity(world, component).path().c_str())] = entry;
+                total += usage.second;
+            }
+        }
+        report["python"] = python_objects;
+        
+        report["total_bytes"] = total;
+        // Part of the total that comes from the estimates above
+        report["estimated_bytes"] = id_record_bytes + index_bytes;
+        return report;
+    }
+
+    // Start (or stop) recording frame, phase, system, observer and graph export spans
+    // of this world. Enabling drops the spans recorded so far. Each thread keeps the
+    // last `capacity` spans of all worlds, the capacity is shared by the worlds and a
+    // thread switches to the new one with its next span.
+    void enable_tracing(bool enabled = true, size_t capacity = 65536) {
+        if (enabled && capacity == 0) {
+            throw std::runtime_error("Trace capacity must be positive");
+        }
+        if (enabled) {
+            // Under the lock, a dump never sees the capacity change
+            std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+            trace_capacity.store(capacity);
+            state->trace_since.store(trace_now());
+        }
+        if (state->tracing.exchange(enabled) != enabled) {
+            trace_worlds += enabled ? 1 : -1;
+        }
+    }
+
+    // Write the recorded spans as Chrome trace event JSON (chrome://tracing, Perfetto).
+    // Phase spans are derived from consecutive systems of the same phase.
+    void dump_trace(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (!file) {
+            throw std::runtime_error("Failed to open trace file: " + path);
+        }
+        
+        auto escape = [](const std::string& str) {
+            std::string result;
+            for (char c : str) {
+                if (c == '"' || c == '\\') {
+                    result += '\\';
+                    result += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    char code[7];
+                    std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                    result += code;
+                } else {
+                    result += c;
+                }
+            }
+            return result;
+        };
+        auto entity_name = [&](ecs_entity_t e, const char* fallback) -> std::string {
+            if (!e || !ecs_is_alive(world, e)) {
+                return fallback;
+            }
+            const char* name = ecs_get_name(world, e);
+            return name ? escape(name) : fallback + std::string(" ") + std::to_string(e);
+        };
+        
+        bool first = true;
+        auto write_event = [&](const std::string& name, const char* category, uint32_t tid,
+            int64_t start, int64_t duration, const std::string& args)
+        {
+            std::fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f%s}",
+                first ? "" : ",", name.c_str(), category, tid, start / 1000.0, duration / 1000.0, args.c_str());
+            first = false;
+        };
+        
+        std::fprintf(file, "{\"traceEvents\":[");
+        int64_t since = state->trace_since.load();
+        std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+        for (const std::shared_ptr<TraceBuffer>& buffer : trace_buffers) {
+            TraceRing* ring = buffer->ring.load(std::memory_order_acquire);
+            if (!ring) {
+                continue;
+            }
+            // The thread may still be recording. Slots it wrapped around to while they
+            // were copied are dropped, the head after the copy tells which.
+            uint64_t size = ring->events.size();
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t begin = head > size ? head - size : 0;
+            std::vector<TraceEvent> copied(ring->events.begin(), ring->events.end());
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = ring->head.load(std::memory_order_relaxed);
+            begin = std::max(begin, after > size ? after - size : 0);
+            
+            std::vector<TraceEvent> events;
+            for (uint64_t i = begin; i < head; i++) {
+                const TraceEvent& event = copied[i % size];
+                if (event.state == state.get() && event.start >= since) {
+                    events.push_back(event);
+                }
+            }
+            std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+                return a.start < b.start;
+            });
+            
+            ecs_entity_t phase = 0;
+            int64_t phase_start = 0;
+            int64_t phase_end = 0;
+            auto close_phase = [&]() {
+                if (phase) {
+                    write_event(entity_name(phase, "phase"), "phase", buffer->thread_id, phase_start, phase_end - phase_start, "");
+                }
+                phase = 0;
+            };
+            
+            for (const TraceEvent& event : events) {
+                int64_t end = event.start + event.duration;
+                switch (event.kind) {
+                case TraceFrame:
+                    close_phase();
+                    write_event("frame", "frame", buffer->thread_id, event.start, event.duration, "");
+                    break;
+                case TraceSystem: {
+                    ecs_entity_t system_phase = event.entity && ecs_is_alive(world, event.entity) ?
+                        ecs_get_target(world, event.entity, EcsDependsOn, 0) : 0;
+                    if (system_phase != phase) {
+                        close_phase();
+                        phase = system_phase;
+                        phase_start = event.start;
+                    }
+                    phase_end = end;
+                    
+                    std::string name = entity_name(event.entity, "system");
+                    write_event(name, "system", buffer->thread_id, event.start, event.duration,
+                        ",\"args\":{\"python_us\":" + std::to_string(event.python / 1000.0) +
+                        ",\"native_us\":" + std::to_string((event.duration - event.python) / 1000.0) + "}");
+                    // Total Python time of the system, drawn from the start of the span
+                    if (event.python) {
+                        write_event(name + " (python)", "python", buffer->thread_id, event.start, event.python, "");
+                    }
+                    break;
+                }
+                case TraceObserver:
+                    write_event(entity_name(event.entity, "observer"), "observer", buffer->thread_id,
+                        event.start, event.duration, ",\"args\":{\"python_us\":" + std::to_string(event.python / 1000.0) + "}");
+                    break;
+                case TraceExportGraph:
+                    write_event("export_graph", "export", buffer->thread_id, event.start, event.duration, "");
+                    break;
+                }
+            }
+            close_phase();
+        }
+        std::fprintf(file, "\n]}\n");
+        std::fclose(file);
+    }
+
+};
+
+// Binding state of the world a bound object belongs to
+BindingState* bound_state(py::handle self) {
+    if (py::isinstance<PyEntity>(self)) {
+        return &binding_state(self.cast<PyEntity&>().entity.world());
+    } else if (py::isinstance<PyWorld>(self)) {
+        return self.cast<PyWorld&>().state.get();
+    } else if (py::isinstance<PyQueryIterator>(self)) {
+        return &binding_state(self.cast<PyQueryIterator&>().world_ptr());
+    } else if (py::isinstance<PyTagSet>(self)) {
+        return self.cast<PyTagSet&>().state.get();
+    } else if (py::isinstance<PyView>(self)) {
+        return self.cast<PyView&>().observer->state.get();
+    } else if (py::isinstance<PyTrackedComponent>(self)) {
+        return self.cast<PyTrackedComponent&>().state.get();
+    }
+    return nullptr;
+}
+
+// Bound on the world, entity and query APIs: outside of callbacks, a world can't be
+// used while one of its frames is running, asynchronous or from progress() on
+// another thread. Other worlds can.
+struct WorldAccess {};
+
+namespace pybind11 { namespace detail {
+template <>
+struct process_attribute<WorldAccess> : process_attribute_default<WorldAccess> {
+    static void precall(function_call& call) {
+        if (!frames_in_any_world.load(std::memory_order_acquire) || frame_callback_depth || call.args.empty()) {
+            return;
+        }
+        BindingState* state = bound_state(call.args[0]);
+        if (state && state->async_frames_in_flight.load(std::memory_order_acquire)) {
+            throw std::runtime_error("The world is running an asynchronous frame, wait for it with result() or await it first");
+        }
+        if (state && state->frames_in_progress.load(std::memory_order_acquire)) {
+            throw std::runtime_error("The world is running a frame in progress() on another thread");
+        }
+    }
 };
+}}
 
+#ifdef Py_GIL_DISABLED
+PYBIND11_MODULE(_core, m, py::mod_gil_not_used()) {
+#else
 PYBIND11_MODULE(_core, m) {
+#endif
     m.doc() = R"pbdoc(
         Flecs Python Bindings
         --------------------
@@ -1709,94 +8041,244 @@ PYBIND11_MODULE(_core, m) {
     m.attr("OnInstantiate") = flecs::OnInstantiate;
     m.attr("Inherit") = flecs::Inherit;
     m.attr("Transitive") = flecs::Transitive;
+    m.attr("OnStart") = EcsOnStart;
+    m.attr("PreFrame") = EcsPreFrame;
+    m.attr("OnLoad") = EcsOnLoad;
+    m.attr("PostLoad") = EcsPostLoad;
+    m.attr("PreUpdate") = EcsPreUpdate;
+    m.attr("OnUpdate") = EcsOnUpdate;
+    m.attr("OnValidate") = EcsOnValidate;
+    m.attr("PostUpdate") = EcsPostUpdate;
+    m.attr("PreStore") = EcsPreStore;
+    m.attr("OnStore") = EcsOnStore;
+    m.attr("PostFrame") = EcsPostFrame;
     
+    // Entity, query and world methods can't run while an asynchronous frame of their world is in flight
+    WorldAccess world_access;
+
     py::class_<PyEntity>(m, "Entity")
-        .def("id", &PyEntity::id)
-        .def("name", &PyEntity::name)
-        .def("path", &PyEntity::path)
-        .def("children", &PyEntity::children)
-        .def("set_name", &PyEntity::set_name)
-        .def("is_alive", &PyEntity::is_alive)
-        .def("destroy", &PyEntity::destroy)
-        .def("has_tag", &PyEntity::has_tag)
-        .def("remove_tag", &PyEntity::remove_tag)
-        .def("add_tag", &PyEntity::add_tag)
-        .def("get_relationship_component", &PyEntity::get_relationship_component)
+        .def("id", &PyEntity::id, world_access)
+        .def("name", &PyEntity::name, world_access)
+        .def("path", &PyEntity::path, world_access)
+        .def("children", &PyEntity::children, world_access)
+        .def("set_name", &PyEntity::set_name, world_access)
+        .def("is_alive", &PyEntity::is_alive, world_access)
+        .def("destroy", &PyEntity::destroy, world_access)
+        .def("enable", py::overload_cast<>(&PyEntity::enable), world_access)
+        .def("disable", py::overload_cast<>(&PyEntity::disable), world_access)
+        .def("is_enabled", py::overload_cast<>(&PyEntity::is_enabled, py::const_), world_access)
+        .def("enable", py::overload_cast<py::object>(&PyEntity::enable), py::arg("component"), world_access)
+        .def("disable", py::overload_cast<py::object>(&PyEntity::disable), py::arg("component"), world_access)
+        .def("is_enabled", py::overload_cast<py::object>(&PyEntity::is_enabled, py::const_), py::arg("component"), world_access)
+        .def("has_tag", &PyEntity::has_tag, world_access)
+        .def("remove_tag", &PyEntity::remove_tag, world_access)
+        .def("add_tag", &PyEntity::add_tag, world_access)
+        .def("get_relationship_component", py::overload_cast<const std::string&, const std::string&>(&PyEntity::get_relationship_component), world_access)
+        .def("get_relationship_component", py::overload_cast<py::object, py::object>(&PyEntity::get_relationship_component), world_access)
         // Overloaded add methods for relationships and tags
-        .def("add", py::overload_cast<const std::string&>(&PyEntity::add))
-        .def("add", py::overload_cast<const std::string&, const std::string&>(&PyEntity::add))
-        .def("add", py::overload_cast<const std::string&, PyEntity&>(&PyEntity::add))
-        .def("add", py::overload_cast<PyEntity&, PyEntity&>(&PyEntity::add))
-        .def("add", py::overload_cast<PyEntity&, const std::string&>(&PyEntity::add))
-        .def("add", py::overload_cast<const std::string&, py::object>(&PyEntity::add))
-        .def("add", py::overload_cast<py::object, const std::string&>(&PyEntity::add))
-        .def("add", py::overload_cast<py::object, py::object>(&PyEntity::add))
-
-        .def("is_a", (&PyEntity::is_a))
-        .def("child_of", (&PyEntity::child_of))
+        .def("add", py::overload_cast<const std::string&>(&PyEntity::add), world_access)
+        .def("add", py::overload_cast<const std::string&, const std::string&>(&PyEntity::add), world_access)
+        .def("add", py::overload_cast<const std::string&, PyEntity&>(&PyEntity::add), world_access)
+        .def("add", py::overload_cast<PyEntity&, PyEntity&>(&PyEntity::add), world_access)
+        .def("add", py::overload_cast<PyEntity&, const std::string&>(&PyEntity::add), world_access)
+        .def("add", py::overload_cast<const std::string&, py::object>(&PyEntity::add), world_access)
+        .def("add", py::overload_cast<py::object, const std::string&>(&PyEntity::add), world_access)
+        .def("add", py::overload_cast<py::object, py::object>(&PyEntity::add), world_access)
+        .def("add", &PyEntity::set_relationship, py::arg("relation"), py::arg("target"),
+             "Add a relationship with native data, e.g. add(\"Friend\", bob, weight=0.8)", world_access)
+
+        .def("is_a", (&PyEntity::is_a), world_access)
+        .def("child_of", (&PyEntity::child_of), world_access)
         // Overloaded has methods
-        .def("has", py::overload_cast<const std::string&>(&PyEntity::has))
-        .def("has", py::overload_cast<const std::string&, const std::string&>(&PyEntity::has))
-        .def("has", py::overload_cast<const std::string&, PyEntity&>(&PyEntity::has))
-        .def("has", py::overload_cast<PyEntity&, PyEntity&>(&PyEntity::has))
-        .def("has", py::overload_cast<PyEntity&, const std::string&>(&PyEntity::has))
-        .def("has", py::overload_cast<const std::string&, py::object>(&PyEntity::has))
-        .def("has", py::overload_cast<py::object, const std::string&>(&PyEntity::has))
-        .def("has", py::overload_cast<py::object, py::object>(&PyEntity::has))
+        .def("has", py::overload_cast<const std::string&>(&PyEntity::has), world_access)
+        .def("has", py::overload_cast<const std::string&, const std::string&>(&PyEntity::has), world_access)
+        .def("has", py::overload_cast<const std::string&, PyEntity&>(&PyEntity::has), world_access)
+        .def("has", py::overload_cast<PyEntity&, PyEntity&>(&PyEntity::has), world_access)
+        .def("has", py::overload_cast<PyEntity&, const std::string&>(&PyEntity::has), world_access)
+        .def("has", py::overload_cast<const std::string&, py::object>(&PyEntity::has), world_access)
+        .def("has", py::overload_cast<py::object, const std::string&>(&PyEntity::has), world_access)
+        .def("has", py::overload_cast<py::object, py::object>(&PyEntity::has), world_access)
         // Overloaded remove methods
-        .def("remove", py::overload_cast<const std::string&>(&PyEntity::remove))
-        .def("remove", py::overload_cast<const std::string&, const std::string&>(&PyEntity::remove))
-        .def("remove", py::overload_cast<const std::string&, PyEntity&>(&PyEntity::remove))
-        .def("remove", py::overload_cast<PyEntity&, PyEntity&>(&PyEntity::remove))
-        .def("remove", py::overload_cast<PyEntity&, const std::string&>(&PyEntity::remove))
-        .def("remove", py::overload_cast<py::object>(&PyEntity::remove))
+        .def("remove", py::overload_cast<const std::string&>(&PyEntity::remove), world_access)
+        .def("remove", py::overload_cast<const std::string&, const std::string&>(&PyEntity::remove), world_access)
+        .def("remove", py::overload_cast<const std::string&, PyEntity&>(&PyEntity::remove), world_access)
+        .def("remove", py::overload_cast<PyEntity&, PyEntity&>(&PyEntity::remove), world_access)
+        .def("remove", py::overload_cast<PyEntity&, const std::string&>(&PyEntity::remove), world_access)
+        .def("remove", py::overload_cast<py::object>(&PyEntity::remove), world_access)
         // Relationship traversal methods
-        .def("get_targets", py::overload_cast<const std::string&>(&PyEntity::get_targets))
-        .def("get_targets", py::overload_cast<PyEntity&>(&PyEntity::get_targets))
+        .def("get_targets", py::overload_cast<const std::string&>(&PyEntity::get_targets), world_access)
+        .def("get_targets", py::overload_cast<PyEntity&>(&PyEntity::get_targets), world_access)
         // Component methods
-        .def("set", &PyEntity::set_component_instance)
-        .def("get", &PyEntity::get_component)
-        .def("add_trait", &PyEntity::add_trait)
+        .def("set", &PyEntity::set_component_instance, world_access)
+        .def("set", &PyEntity::set_native, world_access)
+        .def("get", &PyEntity::get_native, world_access)
+        .def("get", &PyEntity::get_component, py::arg("component_type"), py::arg("track") = false, world_access)
+        .def("modified", &PyEntity::modified, world_access)
+        .def("add_trait", &PyEntity::add_trait, world_access)
         .def("__repr__", [](const PyEntity& e) {
             return e.name() + "(" + std::to_string(e.id()) + ")";
+        }, world_access)
+        // Handles of the same entity are equal, and equal to its id, e.g.
+        // it.event() == ecs.event("Damaged")
+        .def("__eq__", [](const PyEntity& e, py::object other) {
+            if (py::isinstance<PyEntity>(other)) {
+                return e.entity.id() == other.cast<PyEntity>().entity.id();
+            }
+            return py::isinstance<py::int_>(other) && py::int_(e.entity.id()).equal(other);
+        })
+        .def("__hash__", [](const PyEntity& e) {
+            return py::int_(e.entity.id()).attr("__hash__")();
         });
 
         // Bind PyQuery with iterator support
     py::class_<PyQueryIterator>(m, "Query")
         .def("__iter__", &PyQueryIterator::iter, 
-             py::return_value_policy::reference_internal)
-        .def("__next__", &PyQueryIterator::next)
-        .def("reset", &PyQueryIterator::reset);
+             py::return_value_policy::reference_internal, world_access)
+        .def("__next__", &PyQueryIterator::next, world_access)
+        .def("iter", &PyQueryIterator::iter_group, py::arg("group") = py::none(),
+             py::return_value_policy::reference_internal, world_access)
+        .def("reset", &PyQueryIterator::reset, world_access)
+        .def("changed", &PyQueryIterator::changed, world_access)
+        .def("count", &PyQueryIterator::count, "Number of matched rows, without creating Python values", world_access)
+        .def("group_count", &PyQueryIterator::group_count, py::arg("by"),
+             "(groups, counts) arrays for a variable (\"$loc\") or relationship target", world_access)
+        .def("aggregate", &PyQueryIterator::aggregate, py::arg("component"), py::arg("field"), py::arg("op") = "sum",
+             py::arg("by") = py::none(), "sum, min, max or mean of a native field, optionally per group", world_access)
+        .def("parallel_for", &PyQueryIterator::parallel_for, py::arg("kernel"), py::arg("threads") = 0,
+             py::arg("chunk_size") = 4096, py::arg("select") = false,
+             "Run a kernel over the matched rows in chunks on worker threads and reduce the partial results. "
+             "Field arrays passed to the kernel view the columns and are only valid during the call", world_access);
+
+    py::class_<PyFrame>(m, "Frame")
+        .def("done", &PyFrame::done)
+        .def("poll", &PyFrame::poll, "Run the Python callbacks the frame is waiting on, returns done()")
+        .def("result", &PyFrame::result, py::arg("timeout") = py::none(),
+             "Wait for the frame while running its Python callbacks, returns the result of progress")
+        .def("__await__", &PyFrame::await);
+
+    py::class_<PyTagSet>(m, "TagSet")
+        .def("and_", &PyTagSet::and_, world_access)
+        .def("or_", &PyTagSet::or_, world_access)
+        .def("andnot", &PyTagSet::andnot, world_access)
+        .def("__and__", &PyTagSet::and_, world_access)
+        .def("__or__", &PyTagSet::or_, world_access)
+        .def("__sub__", &PyTagSet::andnot, world_access)
+        .def("count", &PyTagSet::count, world_access)
+        .def("__len__", &PyTagSet::count, world_access)
+        .def("__contains__", &PyTagSet::contains, world_access)
+        .def("to_numpy", &PyTagSet::to_numpy, "Entity ids in the set as an int64 array", world_access);
+
+    py::class_<PyView>(m, "View")
+        .def("ids", &PyView::ids, "Array of the matching ids, a copy taken at the current version()", world_access)
+        .def("version", &PyView::version, world_access)
+        .def("delta", &PyView::delta, py::arg("since"), "(added, removed) id arrays since a version", world_access)
+        .def("count", &PyView::count, world_access)
+        .def("__len__", &PyView::count, world_access)
+        .def("__contains__", &PyView::contains, world_access);
+
+#ifndef _WIN32
+    py::class_<PySharedView>(m, "SharedView")
+        .def(py::init<const std::string&>(), py::arg("name"))
+        .def("read", &PySharedView::read, py::arg("copy") = true,
+             "Arrays of the latest publish, copy=False returns read-only views into shared memory")
+        .def("version", &PySharedView::version)
+        .def("close", &PySharedView::close);
+#endif
+
+    py::class_<PyTrackedComponent>(m, "TrackedComponent")
+        .def("__getattr__", &PyTrackedComponent::getattr, world_access)
+        .def("__setattr__", &PyTrackedComponent::setattr, world_access)
+        .def("unwrap", [](const PyTrackedComponent& c) { return c.object; }, world_access)
+        .def("__repr__", [](const PyTrackedComponent& c) {
+            return std::string(py::repr(c.object));
+        }, world_access);
     
     // Bind PyWorld class
     py::class_<PyWorld>(m, "World")
         .def(py::init<>())
-        .def("shutdown", &PyWorld::shutdown_flecs_module, "Explicitly shut down the flecs module and clear Python object references.")
-        .def("entity", py::overload_cast<>(&PyWorld::entity))
-        .def("entity", py::overload_cast<const std::string&>(&PyWorld::entity))
-        .def("entity", py::overload_cast<const std::string&, const py::list&>(&PyWorld::entity))
-        .def("prefab", py::overload_cast<const std::string&>(&PyWorld::prefab))
-        .def("component", &PyWorld::component)
-        .def("prefab", py::overload_cast<const std::string&, const py::list&>(&PyWorld::prefab))
-        .def("lookup", &PyWorld::lookup)
-        .def("progress", &PyWorld::progress, py::arg("delta_time") = 0.0f)
-        .def("info", &PyWorld::info)
-        .def("find_with_tag", &PyWorld::find_with_tag)
-        .def("find_with_tags", &PyWorld::find_with_tags)
-        .def("query", &PyWorld::query)
-        .def("observer", &PyWorld::observer_decorator, py::arg("events") = py::list())
-        .def("system", &PyWorld::system_decorator)
-        .def("observer_iter", &PyWorld::observer_iter_decorator, py::arg("events") = py::list())
-        .def("system_iter", &PyWorld::system_iter_decorator)
+        .def("shutdown", &PyWorld::shutdown_flecs_module, "Explicitly shut down the flecs module and clear Python object references.", world_access)
+        .def("entity", py::overload_cast<>(&PyWorld::entity), world_access)
+        .def("entity", py::overload_cast<const std::string&>(&PyWorld::entity), world_access)
+        .def("entity", py::overload_cast<const std::string&, const py::list&>(&PyWorld::entity), world_access)
+        .def("prefab", py::overload_cast<const std::string&>(&PyWorld::prefab), world_access)
+        .def("component", py::overload_cast<const std::string&>(&PyWorld::component), world_access)
+        .def("component", py::overload_cast<const std::string&, py::dict>(&PyWorld::component), world_access)
+        .def("prefab", py::overload_cast<const std::string&, const py::list&>(&PyWorld::prefab), world_access)
+        .def("lookup", &PyWorld::lookup, world_access)
+        .def("progress", &PyWorld::progress, py::arg("delta_time") = 0.0f, world_access)
+        .def("progress_async", &PyWorld::progress_async, py::arg("delta_time") = 0.0f,
+             "Run a frame on a native thread, returns an awaitable Frame. Waits for the previous frame first")
+        .def("info", &PyWorld::info, world_access)
+        .def("find_with_tag", &PyWorld::find_with_tag, world_access)
+        .def("find_with_tags", &PyWorld::find_with_tags, world_access)
+        .def("tag_set", &PyWorld::tag_set, py::arg("tag"), "Live bitmap of the entities that have a tag", world_access)
+        .def("view", &PyWorld::view, "Live view of the entities matching the terms", world_access)
+        .def("query", &PyWorld::query, py::arg("changed_only") = false,
+             py::arg("group_by") = py::none(), py::arg("order_by") = py::none(), py::arg("memoize") = false,
+             py::arg("where") = py::none(), world_access)
+        .def("observer", &PyWorld::observer_decorator, py::arg("events") = py::list(), py::arg("batch") = false, world_access)
+        .def("event", &PyWorld::event, py::arg("name"), "Create or look up a custom event", world_access)
+        .def("emit", &PyWorld::emit, py::arg("event"), py::arg("ids"), py::arg("payload") = py::none(),
+             py::arg("component") = py::none(), "Emit an event for an array of entity ids", world_access)
+        .def("system", &PyWorld::system_decorator, py::arg("changed_only") = false, py::arg("track_writes") = false,
+             py::arg("phase") = py::none(), py::arg("interval") = 0.0f, py::arg("rate") = 0, py::arg("tick_source") = py::none(),
+             py::arg("cascade") = py::none(), py::arg("multi_threaded") = false, world_access)
+        .def("observer_iter", &PyWorld::observer_iter_decorator, py::arg("events") = py::list(), world_access)
+        .def("system_iter", &PyWorld::system_iter_decorator, py::arg("changed_only") = false,
+             py::arg("phase") = py::none(), py::arg("interval") = 0.0f, py::arg("rate") = 0, py::arg("tick_source") = py::none(),
+             py::arg("cascade") = py::none(), py::arg("multi_threaded") = false, world_access)
+        .def("set_threads", &PyWorld::set_threads, py::arg("threads"),
+             "Run multi_threaded systems on worker threads, each with its own stage", world_access)
+        .def("hierarchy", &PyWorld::hierarchy, py::arg("root"), py::arg("relation") = py::none(), py::arg("order") = "breadth",
+             "Flatten a hierarchy into numpy arrays of entity ids, parent indices and depths", world_access)
+        .def("system_batch", &PyWorld::system_batch_decorator, py::arg("input"), py::arg("output"),
+             py::arg("input_field") = "", py::arg("output_field") = "",
+             py::arg("phase") = py::none(), py::arg("interval") = 0.0f, py::arg("rate") = 0, py::arg("tick_source") = py::none(), world_access)
+        .def("spatial_index", &PyWorld::create_spatial_index, py::arg("component"), py::arg("cell_size") = 1.0f,
+             py::arg("fields") = py::none(), py::arg("threads") = 0, world_access)
+        .def("rebuild_spatial_index", &PyWorld::rebuild_spatial_index, py::arg("threads") = 0, world_access)
+        .def("within_radius", &PyWorld::within_radius, py::arg("center"), py::arg("radius"), world_access)
+        .def("knn", &PyWorld::knn, py::arg("points"), py::arg("k"), py::arg("threads") = 0, world_access)
+#ifndef _WIN32
+        .def("export_shared", &PyWorld::export_shared, py::arg("name"), py::arg("components") = py::list(),
+             py::arg("graph") = false, "Publish native columns and graph arrays to shared memory on every progress()", world_access)
+#endif
+        .def("save_image", &PyWorld::save_image, py::arg("path"),
+             "Write all entities, native columns and pickled Python components to a binary image", world_access)
+        .def_static("load_image", &PyWorld::load_image, py::arg("path"),
+             "Create a world from an image written by save_image")
+        .def("start_journal", &PyWorld::start_journal, py::arg("path"), py::arg("flush_interval") = 0.1,
+             "Record every change made to the world to an append-only journal, starting with its current state. "
+             "Python components mutated in place are only recorded when written through get(T, track=True)", world_access)
+        .def("stop_journal", &PyWorld::stop_journal,
+             "Write out the buffered journal records and close the journal", world_access)
+        .def_static("replay", &PyWorld::replay, py::arg("journal"), py::arg("until_frame") = -1,
+             "Create a world from a journal, up to and including frame until_frame (-1 for all records)")
+        .def("diff", &PyWorld::diff, py::arg("since_version") = 0,
+             "Encode the changes since a version returned by an earlier diff (0 for the whole world), returns (delta, version)", world_access)
+        .def("apply_delta", &PyWorld::apply_delta, py::arg("delta"),
+             "Apply a delta from diff() to this mirror world, returns the version of the delta", world_access)
+        .def("phase", &PyWorld::phase, py::arg("name"), py::arg("depends_on") = py::none(), world_access)
+        .def("timer", &PyWorld::timer, py::arg("interval"), world_access)
+        .def("rate_filter", &PyWorld::rate_filter, py::arg("rate"), py::arg("source") = py::none(), world_access)
         .def("export_graph_numpy", &PyWorld::export_graph_numpy, 
-     "Export graph structure as numpy arrays in a dictionary")
+     "Export graph structure as numpy arrays in a dictionary", world_access)
+        .def("enable_tracing", &PyWorld::enable_tracing, py::arg("enabled") = true, py::arg("capacity") = 65536,
+             "Record frame, phase, system and observer spans in per-thread ring buffers", world_access)
+        .def("dump_trace", &PyWorld::dump_trace, py::arg("path"), "Write recorded spans as Chrome trace event JSON", world_access)
+        .def("enable_rest", &PyWorld::enable_rest, py::arg("port") = 27750, py::arg("bind") = "127.0.0.1",
+             py::arg("sample_interval") = 1.0f, py::arg("system_timings") = false,
+             "Serve the world over HTTP and sample WorldMetrics for live monitoring", world_access)
+        .def("memory_report", &PyWorld::memory_report, py::arg("python") = true, py::arg("sizer") = py::none(),
+             "Memory use by archetype, component, id records, entity index, names and Python objects", world_access)
         .def("__repr__", [](const PyWorld& w) {
             return w.info();
-        });
+        }, world_access);
 
     py::class_<PyIterator>(m, "Iterator")
         .def("event", &PyIterator::event)
         .def("event_name", &PyIterator::event_name)
+        .def("payload", &PyIterator::payload)
         .def("event_id", &PyIterator::event_id)
         .def("event_id_name", &PyIterator::event_id_name)
         .def("count", &PyIterator::count)
@@ -0,0 +1,88 @@
+from __future__ import annotations
+
+import pytest
+
+import flecs
+
+
+def make_world():
+    world = flecs.World()
+    world.component("Position", {"x": "f32", "y": "f32"})
+    for i in range(5):
+        e = world.entity(f"Unit{i}")
+        e.set("Position", {"x": i, "y": -i})
+    world.lookup("Unit0").add("Stunned")
+    return world
+
+
+def test_full_and_incremental_deltas():
+    world = make_world()
+    mirror = flecs.World()
+
+    delta, version = world.diff()
+    assert mirror.apply_delta(delta) == version
+    for i in range(5):
+        assert mirror.lookup(f"Unit{i}").get("Position") == {"x": i, "y": -i}
+    assert mirror.lookup("Unit0").has("Stunned")
+
+    world.lookup("Unit1").set("Position", {"x": 10, "y": 20})
+    world.lookup("Unit0").remove("Stunned")
+    world.lookup("Unit2").add("Stunned")
+    world.lookup("Unit3").destroy()
+    world.entity("Unit5").set("Position", {"x": 5, "y": -5})
+
+    delta, version = world.diff(version)
+    assert mirror.apply_delta(delta) == version
+    assert mirror.lookup("Unit1").get("Position") == {"x": 10, "y": 20}
+    assert not mirror.lookup("Unit0").has("Stunned")
+    assert mirror.lookup("Unit2").has("Stunned")
+    assert mirror.lookup("Unit3").id() == 0
+    assert mirror.lookup("Unit5").get("Position") == {"x": 5, "y": -5}
+    assert mirror.query("Position").count() == world.query("Position").count()
+
+
+def test_dropped_changes_need_a_full_diff():
+    world = make_world()
+    _, version = world.diff()
+
+    # More changes than the log holds, without a diff in between
+    unit = world.lookup("Unit4")
+    for _ in range(40000):
+        unit.add("Stunned")
+        unit.remove("Stunned")
+
+    with pytest.raises(RuntimeError):
+        world.diff(version)
+
+    mirror = flecs.World()
+    delta, _ = world.diff()
+    mirror.apply_delta(delta)
+    assert mirror.lookup("Unit4").get("Position") == {"x": 4, "y": -4}
+
+
+def test_storage_traits_are_mirrored():
+    world = flecs.World()
+    world.component("Health", {"hp": "i32"})
+    world.lookup("Health").add_trait("Sparse")
+    world.entity("Stunned").add_trait("CanToggle")
+    world.entity("Marked").add_trait("DontFragment")
+    unit = world.entity("Unit")
+    unit.set("Health", {"hp": 7})
+    unit.add("Stunned")
+    unit.add("Marked")
+    unit.disable("Stunned")
+
+    mirror = flecs.World()
+    delta, version = world.diff()
+    mirror.apply_delta(delta)
+    mirrored = mirror.lookup("Unit")
+    assert mirrored.get("Health") == {"hp": 7}
+    assert mirrored.has("Marked")
+    assert not mirrored.is_enabled("Stunned")
+
+    unit.set("Health", {"hp": 3})
+    unit.enable("Stunned")
+    delta, version = world.diff(version)
+    mirror.apply_delta(delta)
+    assert mirrored.get("Health") == {"hp": 3}
+    assert mirrored.is_enabled("Stunned")
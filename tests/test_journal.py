@@ -0,0 +1,98 @@
+from __future__ import annotations
+
+import flecs
+
+
+class Inventory:
+    def __init__(self, items):
+        self.items = items
+
+
+def record(world, path):
+    world.component("Position", {"x": "f32", "y": "f32"})
+    world.start_journal(path)
+
+    player = world.entity("Player")
+    player.set(Inventory(["sword"]))
+    crate = world.entity("Crate")
+    for frame in range(6):
+        player.set("Position", {"x": frame, "y": -frame})
+        if frame == 2:
+            player.set(Inventory(["sword", "key"]))
+        if frame == 3:
+            crate.destroy()
+        # Written through a tracked component, so the change is journaled
+        if frame == 4:
+            player.get(Inventory, track=True).items = ["sword", "key", "map"]
+        world.progress()
+
+    world.stop_journal()
+
+
+def test_replay_matches_recorded_world(tmp_path):
+    world = flecs.World()
+    path = str(tmp_path / "world.journal")
+    record(world, path)
+
+    replayed = flecs.World.replay(path)
+    player = replayed.lookup("Player")
+    assert player.get("Position") == world.lookup("Player").get("Position")
+    assert player.get(Inventory).items == ["sword", "key", "map"]
+    assert replayed.lookup("Crate").id() == 0
+
+
+def test_replay_until_frame(tmp_path):
+    world = flecs.World()
+    path = str(tmp_path / "world.journal")
+    record(world, path)
+
+    replayed = flecs.World.replay(path, until_frame=2)
+    player = replayed.lookup("Player")
+    assert player.get("Position") == {"x": 1, "y": -1}
+    assert player.get(Inventory).items == ["sword"]
+    assert replayed.lookup("Crate").id() != 0
+
+
+def test_worlds_are_journaled_separately(tmp_path):
+    first = flecs.World()
+    second = flecs.World()
+    first_path = str(tmp_path / "first.journal")
+    second_path = str(tmp_path / "second.journal")
+    first.start_journal(first_path)
+    second.start_journal(second_path)
+
+    first.entity("Kept")
+    doomed = second.entity("Doomed")
+    second.entity("Kept")
+    doomed.destroy()
+    first.progress()
+    second.progress()
+    first.stop_journal()
+    second.stop_journal()
+
+    assert flecs.World.replay(first_path).lookup("Kept").id() != 0
+    replayed = flecs.World.replay(second_path)
+    assert replayed.lookup("Doomed").id() == 0
+    assert replayed.lookup("Kept").id() != 0
+
+
+def test_replay_keeps_storage_traits(tmp_path):
+    world = flecs.World()
+    path = str(tmp_path / "world.journal")
+    world.start_journal(path)
+    world.component("Health", {"hp": "i32"})
+    world.lookup("Health").add_trait("Sparse")
+    world.entity("Stunned").add_trait("CanToggle")
+    world.entity("Marked").add_trait("DontFragment")
+    unit = world.entity("Unit")
+    unit.set("Health", {"hp": 7})
+    unit.add("Stunned")
+    unit.add("Marked")
+    unit.disable("Stunned")
+    world.progress()
+    world.stop_journal()
+
+    replayed = flecs.World.replay(path).lookup("Unit")
+    assert replayed.get("Health") == {"hp": 7}
+    assert replayed.has("Marked")
+    assert not replayed.is_enabled("Stunned")
@@ -0,0 +1,51 @@
+from __future__ import annotations
+
+import math
+
+import pytest
+
+import flecs
+
+# The index returns numpy arrays
+np = pytest.importorskip("numpy")
+
+
+def make_world():
+    world = flecs.World()
+    world.component("Position", {"x": "f32", "y": "f32"})
+    for i in range(10):
+        world.entity(f"Agent{i}").set("Position", {"x": i, "y": i})
+    # Far from the rest, the occupied cells span a huge range
+    world.entity("Outlier").set("Position", {"x": 1e9, "y": -1e9})
+    world.spatial_index("Position", cell_size=1.0)
+    return world
+
+
+def test_within_radius():
+    world = make_world()
+    near = set(world.within_radius((0, 0), 1.5).tolist())
+    assert near == {world.lookup("Agent0").id(), world.lookup("Agent1").id()}
+    assert len(world.within_radius((0, 0), 1e10)) == 11
+    assert len(world.within_radius((1e30, 1e30), 1.0)) == 0
+
+    with pytest.raises(RuntimeError):
+        world.within_radius((math.nan, 0), 1.0)
+    with pytest.raises(RuntimeError):
+        world.within_radius((0, 0), math.inf)
+
+
+def test_knn_far_point_and_k_above_population():
+    world = make_world()
+
+    ids, _ = world.knn(np.array([[1e15, -1e15]], dtype=np.float32), k=1)
+    assert ids[0, 0] == world.lookup("Outlier").id()
+
+    ids, dist = world.knn(np.array([[0, 0]], dtype=np.float32), k=20)
+    assert (ids[0, :11] != -1).all()
+    assert (ids[0, 11:] == -1).all()
+    assert np.isinf(dist[0, 11:]).all()
+    assert ids[0, 10] == world.lookup("Outlier").id()
+
+    world.lookup("Outlier").destroy()
+    ids, _ = world.knn(np.array([[-1e6, -1e6]], dtype=np.float32), k=1)
+    assert ids[0, 0] == world.lookup("Agent0").id()
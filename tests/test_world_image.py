@@ -0,0 +1,72 @@
+from __future__ import annotations
+
+import flecs
+
+
+class Mesh:
+    def __init__(self, vertices):
+        self.vertices = vertices
+
+
+def populate(world, count):
+    world.component("Position", {"x": "f32", "y": "f32"})
+    for i in range(count):
+        e = world.entity(f"Node{i}")
+        e.set("Position", {"x": i, "y": i * 2})
+        e.set(Mesh([i, i + 1, i + 2]))
+
+
+def test_save_load_round_trip(tmp_path):
+    world = flecs.World()
+    populate(world, 10)
+    path = str(tmp_path / "world.img")
+    world.save_image(path)
+
+    loaded = flecs.World.load_image(path)
+    for i in range(10):
+        node = loaded.lookup(f"Node{i}")
+        assert node.get("Position") == {"x": i, "y": i * 2}
+        assert node.get(Mesh).vertices == [i, i + 1, i + 2]
+
+
+def test_loaded_world_keeps_its_own_objects(tmp_path):
+    world = flecs.World()
+    populate(world, 10)
+    path = str(tmp_path / "world.img")
+    world.save_image(path)
+
+    # Both worlds are alive and reuse the same entity ids
+    loaded = flecs.World.load_image(path)
+    world.lookup("Node3").set(Mesh(["changed"]))
+    assert loaded.lookup("Node3").get(Mesh).vertices == [3, 4, 5]
+
+    # Dropping one world leaves the objects of the other in place
+    del world
+    assert loaded.lookup("Node7").get(Mesh).vertices == [7, 8, 9]
+
+
+def populate_traits(world):
+    world.component("Health", {"hp": "i32"})
+    world.lookup("Health").add_trait("Sparse")
+    world.entity("Stunned").add_trait("CanToggle")
+    world.entity("Marked").add_trait("DontFragment")
+    for i in range(3):
+        e = world.entity(f"Unit{i}")
+        e.set("Health", {"hp": 10 * i})
+        e.add("Stunned")
+        e.add("Marked")
+    world.lookup("Unit1").disable("Stunned")
+
+
+def test_storage_traits_round_trip(tmp_path):
+    world = flecs.World()
+    populate_traits(world)
+    path = str(tmp_path / "world.img")
+    world.save_image(path)
+
+    loaded = flecs.World.load_image(path)
+    for i in range(3):
+        unit = loaded.lookup(f"Unit{i}")
+        assert unit.get("Health") == {"hp": 10 * i}
+        assert unit.has("Marked")
+        assert unit.is_enabled("Stunned") == (i != 1)